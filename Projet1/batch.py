@@ -0,0 +1,59 @@
+import subprocess
+import sys
+import time
+import os
+import random
+import common
+
+tmpFolder="/tmp/batch_inputs/"
+linesFile="/tmp/batch_lines"
+
+# Débit (tablos par seconde) : un processus par fichier, --batch et --lines
+nbrArrays=2000
+minSize=16
+maxSize=4096
+
+def generate() :
+    os.makedirs(tmpFolder, exist_ok=True)
+    paths=[]
+    with open(linesFile, "w") as lines:
+        for i in range(nbrArrays) :
+            text=" ".join(str(v) for v in common.randomValues(random.randint(minSize, maxSize)))
+            path=tmpFolder + "tablo" + str(i)
+            with open(path, "w") as f:
+                f.write(text + "\n")
+            lines.write(text + "\n")
+            paths.append(path)
+    return paths
+
+def processPerFile(binFile, paths) :
+    start=time.time()
+    output=""
+    for path in paths :
+        output+=subprocess.run([binFile, path], stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return time.time() - start, output
+
+def oneProcess(binFile, options) :
+    start=time.time()
+    output=subprocess.run([binFile] + options, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return time.time() - start, output
+
+def batch(name) :
+    binFile=common.compile(name)
+    paths=generate()
+
+    perFile, perFileOutput = processPerFile(binFile, paths)
+    batched, batchOutput = oneProcess(binFile, ["--batch"] + paths)
+    lines, linesOutput = oneProcess(binFile, ["--lines", linesFile])
+    if perFileOutput != batchOutput or perFileOutput != linesOutput :
+        print("Résultats différents", file=sys.stderr)
+
+    print("mode;arrays;time;arrays_per_s;speedup")
+    print("process_per_file;" + str(nbrArrays) + ";" + str(perFile) + ";" + str(nbrArrays / perFile) + ";1.0")
+    print("batch;" + str(nbrArrays) + ";" + str(batched) + ";" + str(nbrArrays / batched) + ";" + str(perFile / batched))
+    print("lines;" + str(nbrArrays) + ";" + str(lines) + ";" + str(nbrArrays / lines) + ";" + str(perFile / lines))
+
+if len(sys.argv) > 1:
+    batch(sys.argv[1])
+else :
+    batch("rakotomalala")
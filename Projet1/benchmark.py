@@ -0,0 +1,35 @@
+import sys
+import common
+
+tmpFile="/tmp/benchmark_input"
+
+# Tailles puissances de 2 : la version arbre ne gère que ces tailles
+sizes=[2**16, 2**20, 2**22, 2**24]
+runs=3
+
+def computeTime(run) :
+    timings, output = run
+    return sum(float(value) for step, value in timings.items() if step not in ("kernels", "type", "parse", "displayResult"))
+
+def timeRun(binFile, options) :
+    # Somme des temps de calcul affichés par --time, hors lecture et affichage (meilleur de 'runs' exécutions)
+    best=common.bestRun(runs, lambda : common.timeRun([binFile, "--time"] + options + [tmpFile]), computeTime)
+    return computeTime(best), best[1]
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("size;tree_scalar;tree;chunked;fused;speedup_simd;speedup_chunked;speedup_fused")
+    for size in sizes :
+        common.writeText(tmpFile, common.randomValues(size))
+        treeScalar, treeScalarOutput = timeRun(binFile, ["--tree", "--simd", "scalar"])
+        tree, treeOutput = timeRun(binFile, ["--tree"])
+        chunked, chunkedOutput = timeRun(binFile, [])
+        fused, fusedOutput = timeRun(binFile, ["--fused"])
+        if treeOutput != treeScalarOutput or treeOutput != chunkedOutput or treeOutput != fusedOutput :
+            print("Résultats différents pour la taille " + str(size), file=sys.stderr)
+        print(str(size) + ";" + str(treeScalar) + ";" + str(tree) + ";" + str(chunked) + ";" + str(fused) + ";" + str(treeScalar / tree) + ";" + str(tree / chunked) + ";" + str(tree / fused))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
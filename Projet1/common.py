@@ -0,0 +1,61 @@
+from subprocess import STDOUT, CalledProcessError
+from array import array
+import subprocess
+import sys
+import random
+
+# Fonctions communes aux scripts de mesure : compilation, génération des entrées et exécution avec --time
+
+binFolder="bin/"
+srcFolder="src/"
+flags=["-std=c99", "-O2"]
+libraries=["-lm", "-fopenmp"]
+
+def compile(f, compiler="gcc", options=[], suffix="") :
+    name=binFolder + f + suffix
+    try:
+        subprocess.check_output([compiler] + flags + options + ["-o", name, srcFolder + f + ".c"] + libraries, stderr=STDOUT, universal_newlines=True)
+    except  CalledProcessError as e :
+        print(e.output)
+        sys.exit(1)
+    return name
+
+def randomValues(size) :
+    return [random.randint(-100, 100) for _ in range(size)]
+
+def writeText(path, values) :
+    with open(path, "w") as f:
+        f.write(" ".join(str(v) for v in values))
+        f.write("\n")
+
+def binaryHeader(size) :
+    # En-tête du format binaire (voir struct binaryHeader) : entiers de 8 octets, ordre des octets de la machine
+    return b"TABLOBIN" + array("Q", [size]).tobytes() + array("I", [8, 0x01020304]).tobytes() + array("Q", [0]).tobytes()
+
+def writeBinary(path, values) :
+    with open(path, "wb") as f:
+        f.write(binaryHeader(len(values)))
+        f.write(array("q", values).tobytes())
+
+def parseTimings(text) :
+    # Lignes "étape : valeur" affichées par --time sur la sortie d'erreur
+    timings={}
+    for line in text.splitlines() :
+        if " : " in line :
+            step, value = line.split(" : ")
+            timings[step]=value.split()[0]
+    return timings
+
+def timeRun(command, stdout=subprocess.PIPE, env=None, input=None) :
+    # Durées affichées par --time et sortie standard (None si elle est redirigée vers un fichier)
+    result = subprocess.run(command, input=input, stdout=stdout, stderr=subprocess.PIPE, universal_newlines=True, env=env)
+    return parseTimings(result.stderr), result.stdout
+
+def bestRun(runs, run, cost) :
+    # Résultat de run() dont cost() est le plus petit sur 'runs' exécutions
+    best=None
+    for r in range(runs) :
+        result=run()
+        if best is None or cost(result) < cost(best) :
+            best=result
+    return best
@@ -0,0 +1,21 @@
+from os import listdir
+from os.path import isfile, join
+import subprocess
+import sys
+import common
+
+dataFolder="data/"
+
+# Convertit les fichiers texte de data/ (test*) au format binaire (test*.bin) avec l'option --convert
+
+def convertAll(name) :
+    binFile=common.compile(name)
+    for f in sorted(listdir(dataFolder)) :
+        if isfile(join(dataFolder, f)) and f.startswith("test") and not f.endswith(".bin") :
+            subprocess.check_call([binFile, "--convert", join(dataFolder, f + ".bin"), join(dataFolder, f)])
+            print(join(dataFolder, f) + " -> " + join(dataFolder, f + ".bin"))
+
+if len(sys.argv) > 1:
+    convertAll(sys.argv[1])
+else :
+    convertAll("rakotomalala")
@@ -0,0 +1,51 @@
+import subprocess
+import sys
+import random
+import time
+import common
+
+tmpFile="/tmp/queries_input"
+queriesFile="/tmp/queries_ranges"
+windowFile="/tmp/queries_window"
+
+# Index de requêtes (--queries) comparé à une exécution complète par intervalle
+size=2**22
+nbrQueries=10**6
+nbrChecks=20 # Intervalles vérifiés (et chronométrés) avec une exécution par intervalle
+
+def generate() :
+    values=common.randomValues(size)
+    common.writeText(tmpFile, values)
+    queries=[]
+    with open(queriesFile, "w") as f:
+        for q in range(nbrQueries) :
+            left=random.randrange(size)
+            right=random.randrange(left, size)
+            queries.append((left, right))
+            f.write(str(left) + " " + str(right) + "\n")
+    return values, queries
+
+def queries(name) :
+    binFile=common.compile(name)
+    values, ranges = generate()
+
+    timings, output = common.timeRun([binFile, "--time", "--queries", queriesFile, tmpFile])
+    answers=output.splitlines()
+
+    # Méthode actuelle : une exécution complète du programme par intervalle
+    start=time.time()
+    for q in range(nbrChecks) :
+        left, right = ranges[q]
+        common.writeText(windowFile, values[left:right + 1])
+        output=subprocess.run([binFile, windowFile], stdout=subprocess.PIPE, universal_newlines=True).stdout
+        if output.split()[0] != answers[q].split()[0] :
+            print("Résultat différent pour la requête " + str(q), file=sys.stderr)
+    rerun=(time.time() - start) / nbrChecks
+
+    print("size;queries;build;answer;queries_per_s;rerun_per_query;speedup")
+    print(str(size) + ";" + str(nbrQueries) + ";" + timings["buildQueryIndex"] + ";" + timings["answerQueries"] + ";" + timings["throughput"] + ";" + str(rerun) + ";" + str(rerun * float(timings["throughput"])))
+
+if len(sys.argv) > 1:
+    queries(sys.argv[1])
+else :
+    queries("rakotomalala")
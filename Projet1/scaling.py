@@ -0,0 +1,48 @@
+import sys
+import os
+import common
+
+tmpFile="/tmp/scaling_input"
+
+# Passage à l'échelle de la version MPI (mpicc -DUSE_MPI)
+procs=[1, 2, 4, 8]
+strongSize=2**24 # Taille totale fixe (strong scaling)
+weakSize=2**22 # Taille par processus (weak scaling)
+threads=1 # OMP_NUM_THREADS de chaque processus
+runs=3
+
+def generate(size) :
+    # Fichier binaire (voir struct binaryHeader) : la lecture ne fausse pas les mesures
+    common.writeBinary(tmpFile, common.randomValues(size))
+
+def timeRun(binFile, np) :
+    # Durée totale affichée par P0 avec --time (meilleure de 'runs' exécutions)
+    env=dict(os.environ, OMP_NUM_THREADS=str(threads))
+    timings, output = common.bestRun(runs, lambda : common.timeRun(["mpirun", "--oversubscribe", "-np", str(np), binFile, "--time", tmpFile], env=env), lambda run : float(run[0]["distributedMaximum"]))
+    return float(timings["distributedMaximum"])
+
+def scaling(name) :
+    binFile=common.compile(name, "mpicc", ["-DUSE_MPI"], "_mpi")
+
+    print("strong;procs;size;time;speedup;efficiency")
+    generate(strongSize)
+    reference=None
+    for np in procs :
+        t=timeRun(binFile, np)
+        if reference is None :
+            reference=t
+        print("strong;" + str(np) + ";" + str(strongSize) + ";" + str(t) + ";" + str(reference / t) + ";" + str(reference / t / np))
+
+    print("weak;procs;size;time;speedup;efficiency")
+    reference=None
+    for np in procs :
+        generate(weakSize * np)
+        t=timeRun(binFile, np)
+        if reference is None :
+            reference=t
+        print("weak;" + str(np) + ";" + str(weakSize * np) + ";" + str(t) + ";" + str(reference * np / t) + ";" + str(reference / t))
+
+if len(sys.argv) > 1:
+    scaling(sys.argv[1])
+else :
+    scaling("rakotomalala")
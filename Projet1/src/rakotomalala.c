@@ -1,13 +1,106 @@
+#define _GNU_SOURCE // mmap(), fileno() avec -std=c99
 #include <stdlib.h>
 #include <stdio.h>
-#include <tgmath.h> // fmaxl()
+#include <string.h> // strcmp()
+#include <stdint.h> // Entiers de taille fixe de l'en-tête binaire
 #include <limits.h> // Élément neutre du max des entiers long
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h> // fstat()
 #include <math.h> // pow(), log2()
 #include <omp.h> // #pragma
+#ifdef USE_MPI
+#include <mpi.h> // Version distribuée (mpicc -DUSE_MPI)
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h> // SSE4.2, AVX2, AVX-512
+#endif
+
+// Opérateurs et sens de parcours du balayage par blocs
+#define SCAN_SUM 0
+#define SCAN_MAX 1
+#define SCAN_PREFIX 0
+#define SCAN_SUFFIX 1
+
+// Nombre d'éléments traités par appel de noyau dans les boucles parallèles de l'arbre
+#define KERNEL_BLOCK 1024
+
+// Taille des blocs de la version fusionnée (--fused), choisie pour tenir dans le cache L1 / L2
+#define FUSED_BLOCK 4096
+
+// Format binaire des tablos (voir struct binaryHeader)
+#define BINARY_MAGIC "TABLOBIN"
+#define BINARY_ENDIANNESS 0x01020304
+
+// Taille du tampon de lecture des fichiers texte par blocs (struct reader)
+#define READER_BUFFER (1 << 20)
+
+// Taille du tampon d'écriture du résultat (struct writer)
+#define WRITER_BUFFER (1 << 20)
+
+// Nombre de valeurs de M à partir duquel findSegment() cherche le maximum et la fin de la sous-séquence en parallèle
+#define SEGMENT_PARALLEL (1 << 16)
+
+// Nombre d'entiers par bloc du mode --stream par défaut
+#define STREAM_BLOCK (1 << 20)
+
+// Mode --batch / --lines : nombre de tablos traités avant d'écrire leurs résultats dans l'ordre
+#define BATCH_CHUNK 1024
+
+// Mode --batch / --lines : taille (en octets) à partir de laquelle un tablo est traité par toute l'équipe de threads
+#define BATCH_LARGE (1 << 20)
+
+// Nombre d'entiers résumés par feuille de l'index de requêtes (struct queryIndex)
+#define QUERY_LEAF 32
+
+// Mode --top --naive : valeur qui remplace les sous-séquences déjà choisies, plus petite que toute somme d'entiers non masqués
+#define TOP_MASK (-(LONG_MAX / 4))
+
+// Type des entiers du balayage par blocs (--type, choisi par elementType() par défaut)
+#define TYPE_INT32 0
+#define TYPE_INT64 1
+#define TYPE_CHECKED 2
+
+// Arène des tablos de calcul : alignement de chaque tablo (ligne de cache) et taille d'une grande page
+#define ARENA_ALIGN 64
+#define HUGE_PAGE (1 << 21)
+// En dessous (en-têtes, petits tablos), la zone est mise à zéro sans lancer de threads
+#define ARENA_PARALLEL_TOUCH (1 << 16)
+
+// Version MPI : octets lus après la tranche de texte d'un processus pour terminer son dernier entier
+#define SLICE_OVERLAP 64
 
 struct tablo {
     long *tab;
     int size;
+    void *mapping; // Projection du fichier binaire dont 'tab' fait partie (NULL si 'tab' vient de malloc)
+    size_t mappingSize;
+    struct arena *arena; // Arène qui contient le tablo (NULL sinon), libérée avec releaseArena() / freeArena()
+};
+
+/**
+ * Zone mémoire réservée une fois par exécution pour les tablos de calcul, découpée par simple incrément.
+ * Les tablos y sont alignés sur ARENA_ALIGN octets ; markArena() / releaseArena() libèrent d'un coup les tablos
+ * temporaires d'un calcul pour que le suivant réutilise les mêmes pages.
+ */
+struct arena {
+    char *base;
+    size_t capacity;
+    size_t used;
+    size_t touched; // Octets déjà touchés une première fois
+    int huge; // 1 si les pages viennent de MAP_HUGETLB
+};
+
+/**
+ * En-tête des fichiers binaires, suivi des 'count' entiers de 'width' octets.
+ * 'endianness' vaut BINARY_ENDIANNESS écrit dans l'ordre des octets de la machine qui a créé le fichier.
+ * La taille de l'en-tête (32 octets) garde les entiers alignés dans la projection mémoire.
+ */
+struct binaryHeader {
+    char magic[8];
+    uint64_t count;
+    uint32_t width;
+    uint32_t endianness;
+    uint64_t reserved;
 };
 
 void printTablo(struct tablo *tmp) {
@@ -24,339 +117,3512 @@ struct tablo *allocateTablo(int size) {
     struct tablo *tmp = malloc(sizeof(struct tablo));
     tmp->size = size;
     tmp->tab = malloc(size * sizeof(long));
+    tmp->mapping = NULL;
+    tmp->mappingSize = 0;
+    tmp->arena = NULL;
+    
+    return tmp;
+}
+
+void freeTablo(struct tablo *tmp) {
+    // Un tablo d'une arène est libéré avec elle
+    if (tmp->arena != NULL)
+        return;
+    
+    if (tmp->mapping != NULL)
+        munmap(tmp->mapping, tmp->mappingSize);
+    else
+        free(tmp->tab);
+    free(tmp);
+}
+
+/**
+ * Taille occupée dans une arène par un tablo (en-tête et entiers, chacun aligné sur ARENA_ALIGN)
+ * @param size nombre d'entiers du tablo
+ * @return la taille en octets
+ */
+size_t arenaBytes(int size) {
+    size_t header = (sizeof(struct tablo) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    size_t values = ((size_t) size * sizeof(long) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    
+    return header + values;
+}
+
+/**
+ * Réserve une arène : grandes pages de HUGE_PAGE octets si le système en a (MAP_HUGETLB), sinon pages normales
+ * avec une demande de grandes pages transparentes (madvise()). Les pages ne sont pas touchées ici.
+ * @param capacity taille minimale de l'arène en octets
+ * @return l'arène réservée
+ */
+struct arena *createArena(size_t capacity) {
+    struct arena *arena = malloc(sizeof(struct arena));
+    arena->capacity = (capacity + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+    arena->used = 0;
+    arena->touched = 0;
+    arena->huge = 0;
+    arena->base = MAP_FAILED;
+    
+    if (arena->capacity == 0)
+        arena->capacity = HUGE_PAGE;
+    
+#ifdef MAP_HUGETLB
+    arena->base = mmap(NULL, arena->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    arena->huge = arena->base != MAP_FAILED;
+#endif
+    
+    if (arena->base == MAP_FAILED) {
+        arena->base = mmap(NULL, arena->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena->base == MAP_FAILED) {
+            printf("Erreur sur la réservation de l'arène\n");
+            exit(1);
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(arena->base, arena->capacity, MADV_HUGEPAGE);
+#endif
+    }
+    
+    return arena;
+}
+
+/**
+ * Alloue une zone alignée sur ARENA_ALIGN octets dans une arène. La partie jamais utilisée de l'arène est touchée
+ * en premier avec la même répartition statique des indices que les boucles parallèles des calculs : chaque page est
+ * placée sur le nœud NUMA du thread qui la traitera (au-delà de ARENA_PARALLEL_TOUCH octets). Comme avec malloc(),
+ * le contenu n'est pas initialisé.
+ * @param *arena arène
+ * @param bytes taille de la zone en octets
+ * @return la zone allouée
+ */
+void *arenaAlloc(struct arena *arena, size_t bytes) {
+    size_t size = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    
+    if (arena->used + size > arena->capacity) {
+        printf("Erreur : arène trop petite\n");
+        exit(1);
+    }
+    
+    char *block = arena->base + arena->used;
+    arena->used += size;
+    
+    if (arena->used > arena->touched) {
+        if (size < ARENA_PARALLEL_TOUCH) {
+            memset(block, 0, size);
+        } else {
+            long *values = (long *) block;
+            long count = size / sizeof(long);
+            #pragma omp parallel for schedule(static)
+            for (long i = 0; i < count; i++) {
+                values[i] = 0;
+            }
+        }
+        arena->touched = arena->used;
+    }
+    
+    return block;
+}
+
+/**
+ * Alloue un tablo dans une arène (en-tête et entiers, voir arenaAlloc())
+ * @param *arena arène
+ * @param size nombre d'entiers du tablo
+ * @return le tablo alloué
+ */
+struct tablo *arenaTablo(struct arena *arena, int size) {
+    struct tablo *tmp = arenaAlloc(arena, sizeof(struct tablo));
+    tmp->tab = arenaAlloc(arena, (size_t) size * sizeof(long));
+    tmp->size = size;
+    tmp->mapping = NULL;
+    tmp->mappingSize = 0;
+    tmp->arena = arena;
     
     return tmp;
 }
 
-void freeTablo(struct tablo *tmp) {
-    free(tmp->tab);
-    free(tmp);
+/**
+ * Position courante d'une arène, à passer à releaseArena()
+ * @param *arena arène
+ * @return la position
+ */
+size_t markArena(struct arena *arena) {
+    return arena->used;
+}
+
+/**
+ * Libère d'un coup tous les tablos alloués dans une arène depuis markArena()
+ * @param *arena arène
+ * @param mark position obtenue avec markArena()
+ * @return void
+ */
+void releaseArena(struct arena *arena, size_t mark) {
+    arena->used = mark;
+}
+
+void freeArena(struct arena *arena) {
+    munmap(arena->base, arena->capacity);
+    free(arena);
+}
+
+/**
+ * Noyaux entiers utilisés par les balayages de l'arbre (up, down, final et leurs versions max).
+ * Chaque noyau existe en version scalaire, SSE4.2 (2 entiers long), AVX2 (4) et AVX-512 (8) ;
+ * la version utilisée est choisie au lancement selon le processeur (selectKernels()).
+ */
+struct kernels {
+    char *name;
+    // out[k] = op(in[2k], in[2k + 1])
+    void (*pairs)(long *out, long *in, int count, int operator);
+    // Préfixe : out[2m] = parent[m], out[2m + 1] = op(parent[m], a[2m])
+    // Suffixe : out[2m] = op(parent[m], a[2m + 1]), out[2m + 1] = parent[m]
+    void (*spread)(long *out, long *parent, long *a, int count, int operator, int direction);
+    // b[i] = op(b[i], a[i])
+    void (*elements)(long *b, long *a, int count, int operator);
+};
+
+void pairsScalar(long *out, long *in, int count, int operator) {
+    for (int k = 0; k < count; k++) {
+        if (operator == SCAN_SUM)
+            out[k] = in[2 * k] + in[2 * k + 1];
+        else
+            out[k] = (in[2 * k] > in[2 * k + 1]) ? in[2 * k] : in[2 * k + 1];
+    }
+}
+
+void spreadScalar(long *out, long *parent, long *a, int count, int operator, int direction) {
+    for (int m = 0; m < count; m++) {
+        long other = a[2 * m + direction];
+        long value;
+        
+        if (operator == SCAN_SUM)
+            value = parent[m] + other;
+        else
+            value = (parent[m] > other) ? parent[m] : other;
+        
+        out[2 * m + direction] = parent[m];
+        out[2 * m + 1 - direction] = value;
+    }
+}
+
+void elementsScalar(long *b, long *a, int count, int operator) {
+    for (int i = 0; i < count; i++) {
+        if (operator == SCAN_SUM)
+            b[i] += a[i];
+        else
+            b[i] = (a[i] > b[i]) ? a[i] : b[i];
+    }
+}
+
+#if defined(__x86_64__)
+
+// SSE4.2 : _mm_cmpgt_epi64 permet le max des entiers 64 bits
+static inline __attribute__((always_inline, target("sse4.2"))) __m128i opSse(__m128i x, __m128i y, int operator) {
+    if (operator == SCAN_SUM)
+        return _mm_add_epi64(x, y);
+    return _mm_blendv_epi8(y, x, _mm_cmpgt_epi64(x, y));
+}
+
+__attribute__((target("sse4.2"))) void pairsSse(long *out, long *in, int count, int operator) {
+    int k = 0;
+    for (; k + 2 <= count; k += 2) {
+        __m128i x = _mm_loadu_si128((__m128i *) (in + 2 * k));
+        __m128i y = _mm_loadu_si128((__m128i *) (in + 2 * k + 2));
+        __m128i even = _mm_unpacklo_epi64(x, y);
+        __m128i odd = _mm_unpackhi_epi64(x, y);
+        _mm_storeu_si128((__m128i *) (out + k), opSse(even, odd, operator));
+    }
+    pairsScalar(out + k, in + 2 * k, count - k, operator);
+}
+
+__attribute__((target("sse4.2"))) void spreadSse(long *out, long *parent, long *a, int count, int operator, int direction) {
+    int m = 0;
+    for (; m + 2 <= count; m += 2) {
+        __m128i x = _mm_loadu_si128((__m128i *) (a + 2 * m));
+        __m128i y = _mm_loadu_si128((__m128i *) (a + 2 * m + 2));
+        __m128i other = (direction == SCAN_PREFIX) ? _mm_unpacklo_epi64(x, y) : _mm_unpackhi_epi64(x, y);
+        __m128i p = _mm_loadu_si128((__m128i *) (parent + m));
+        __m128i value = opSse(p, other, operator);
+        __m128i first = (direction == SCAN_PREFIX) ? p : value;
+        __m128i second = (direction == SCAN_PREFIX) ? value : p;
+        _mm_storeu_si128((__m128i *) (out + 2 * m), _mm_unpacklo_epi64(first, second));
+        _mm_storeu_si128((__m128i *) (out + 2 * m + 2), _mm_unpackhi_epi64(first, second));
+    }
+    spreadScalar(out + 2 * m, parent + m, a + 2 * m, count - m, operator, direction);
+}
+
+__attribute__((target("sse4.2"))) void elementsSse(long *b, long *a, int count, int operator) {
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i x = _mm_loadu_si128((__m128i *) (b + i));
+        __m128i y = _mm_loadu_si128((__m128i *) (a + i));
+        _mm_storeu_si128((__m128i *) (b + i), opSse(x, y, operator));
+    }
+    elementsScalar(b + i, a + i, count - i, operator);
+}
+
+// AVX2 : les dépaquetages travaillent par moitié de 128 bits, d'où les permutations
+static inline __attribute__((always_inline, target("avx2"))) __m256i opAvx2(__m256i x, __m256i y, int operator) {
+    if (operator == SCAN_SUM)
+        return _mm256_add_epi64(x, y);
+    return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi64(x, y));
+}
+
+__attribute__((target("avx2"))) void pairsAvx2(long *out, long *in, int count, int operator) {
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m256i x = _mm256_loadu_si256((__m256i *) (in + 2 * k));
+        __m256i y = _mm256_loadu_si256((__m256i *) (in + 2 * k + 4));
+        __m256i value = opAvx2(_mm256_unpacklo_epi64(x, y), _mm256_unpackhi_epi64(x, y), operator);
+        _mm256_storeu_si256((__m256i *) (out + k), _mm256_permute4x64_epi64(value, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    pairsScalar(out + k, in + 2 * k, count - k, operator);
+}
+
+__attribute__((target("avx2"))) void spreadAvx2(long *out, long *parent, long *a, int count, int operator, int direction) {
+    int m = 0;
+    for (; m + 4 <= count; m += 4) {
+        __m256i x = _mm256_loadu_si256((__m256i *) (a + 2 * m));
+        __m256i y = _mm256_loadu_si256((__m256i *) (a + 2 * m + 4));
+        __m256i other = (direction == SCAN_PREFIX) ? _mm256_unpacklo_epi64(x, y) : _mm256_unpackhi_epi64(x, y);
+        other = _mm256_permute4x64_epi64(other, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i p = _mm256_loadu_si256((__m256i *) (parent + m));
+        __m256i value = opAvx2(p, other, operator);
+        __m256i first = (direction == SCAN_PREFIX) ? p : value;
+        __m256i second = (direction == SCAN_PREFIX) ? value : p;
+        __m256i low = _mm256_unpacklo_epi64(first, second);
+        __m256i high = _mm256_unpackhi_epi64(first, second);
+        _mm256_storeu_si256((__m256i *) (out + 2 * m), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256((__m256i *) (out + 2 * m + 4), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    spreadScalar(out + 2 * m, parent + m, a + 2 * m, count - m, operator, direction);
+}
+
+__attribute__((target("avx2"))) void elementsAvx2(long *b, long *a, int count, int operator) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256((__m256i *) (b + i));
+        __m256i y = _mm256_loadu_si256((__m256i *) (a + i));
+        _mm256_storeu_si256((__m256i *) (b + i), opAvx2(x, y, operator));
+    }
+    elementsScalar(b + i, a + i, count - i, operator);
+}
+
+// AVX-512 : max 64 bits natif et permutations à deux sources
+static inline __attribute__((always_inline, target("avx512f"))) __m512i opAvx512(__m512i x, __m512i y, int operator) {
+    if (operator == SCAN_SUM)
+        return _mm512_add_epi64(x, y);
+    return _mm512_max_epi64(x, y);
+}
+
+__attribute__((target("avx512f"))) void pairsAvx512(long *out, long *in, int count, int operator) {
+    __m512i evens = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    __m512i odds = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    int k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m512i x = _mm512_loadu_si512(in + 2 * k);
+        __m512i y = _mm512_loadu_si512(in + 2 * k + 8);
+        __m512i value = opAvx512(_mm512_permutex2var_epi64(x, evens, y), _mm512_permutex2var_epi64(x, odds, y), operator);
+        _mm512_storeu_si512(out + k, value);
+    }
+    pairsScalar(out + k, in + 2 * k, count - k, operator);
+}
+
+__attribute__((target("avx512f"))) void spreadAvx512(long *out, long *parent, long *a, int count, int operator, int direction) {
+    __m512i select = (direction == SCAN_PREFIX) ? _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0) : _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    __m512i low = _mm512_set_epi64(11, 3, 10, 2, 9, 1, 8, 0);
+    __m512i high = _mm512_set_epi64(15, 7, 14, 6, 13, 5, 12, 4);
+    int m = 0;
+    for (; m + 8 <= count; m += 8) {
+        __m512i x = _mm512_loadu_si512(a + 2 * m);
+        __m512i y = _mm512_loadu_si512(a + 2 * m + 8);
+        __m512i p = _mm512_loadu_si512(parent + m);
+        __m512i value = opAvx512(p, _mm512_permutex2var_epi64(x, select, y), operator);
+        __m512i first = (direction == SCAN_PREFIX) ? p : value;
+        __m512i second = (direction == SCAN_PREFIX) ? value : p;
+        _mm512_storeu_si512(out + 2 * m, _mm512_permutex2var_epi64(first, low, second));
+        _mm512_storeu_si512(out + 2 * m + 8, _mm512_permutex2var_epi64(first, high, second));
+    }
+    spreadScalar(out + 2 * m, parent + m, a + 2 * m, count - m, operator, direction);
+}
+
+__attribute__((target("avx512f"))) void elementsAvx512(long *b, long *a, int count, int operator) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i x = _mm512_loadu_si512(b + i);
+        __m512i y = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(b + i, opAvx512(x, y, operator));
+    }
+    elementsScalar(b + i, a + i, count - i, operator);
+}
+
+#endif
+
+struct kernels kernels = { "scalar", pairsScalar, spreadScalar, elementsScalar };
+
+/**
+ * Choisit les noyaux les plus larges supportés par le processeur
+ * @param *name jeu de noyaux imposé ("scalar", "sse4.2", "avx2", "avx512") ou NULL pour la détection automatique
+ * @return void
+ */
+void selectKernels(char *name) {
+#if defined(__x86_64__)
+    struct kernels available[] = {
+        { "avx512", pairsAvx512, spreadAvx512, elementsAvx512 },
+        { "avx2", pairsAvx2, spreadAvx2, elementsAvx2 },
+        { "sse4.2", pairsSse, spreadSse, elementsSse }
+    };
+    int supported[] = {
+        __builtin_cpu_supports("avx512f"),
+        __builtin_cpu_supports("avx2"),
+        __builtin_cpu_supports("sse4.2")
+    };
+    
+    for (int i = 0; i < 3; i++) {
+        if (supported[i] && (name == NULL || strcmp(name, available[i].name) == 0)) {
+            kernels = available[i];
+            return;
+        }
+    }
+#endif
+    kernels = (struct kernels) { "scalar", pairsScalar, spreadScalar, elementsScalar };
+}
+
+/**
+ * Indique si un caractère sépare deux entiers dans un fichier texte
+ * @param c caractère lu
+ * @return 1 pour un blanc (espace, tabulation, fin de ligne), 0 sinon
+ */
+int isBlank(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * Lecture d'un entier long en base 10 (version simplifiée de strtol(), sans gestion du dépassement)
+ * @param *text début de l'entier (signe éventuel puis chiffres)
+ * @param *end fin du texte disponible
+ * @param *value entier lu
+ * @return la position du premier caractère qui suit l'entier
+ */
+char *parseLong(char *text, char *end, long *value) {
+    int negative = 0;
+    unsigned long nb = 0;
+    
+    if (text < end && (*text == '-' || *text == '+')) {
+        negative = *text == '-';
+        text++;
+    }
+    
+    while (text < end && *text >= '0' && *text <= '9') {
+        nb = nb * 10 + (*text - '0');
+        text++;
+    }
+    
+    // Le reste du mot (caractères invalides) est ignoré
+    while (text < end && !isBlank(*text)) {
+        text++;
+    }
+    
+    *value = negative ? -nb : nb;
+    
+    return text;
+}
+
+/**
+ * Lecture parallèle des entiers d'un texte en mémoire dont le premier caractère est dans [first, last[.
+ * La plage est découpée en autant de plages d'octets que de threads ; un entier appartient à la plage qui contient
+ * son premier caractère. Chaque thread lit ses entiers dans un tampon local, puis la somme préfixe des nombres
+ * d'entiers lus donne la position de chaque tampon dans le tablo.
+ * @param *text texte à lire
+ * @param first début de la plage
+ * @param last fin de la plage (exclue)
+ * @param length taille du texte (un entier commencé avant 'last' peut se terminer après)
+ * @return le tablo lu
+ */
+struct tablo *parseText(char *text, size_t first, size_t last, size_t length) {
+    int nbr_threads = omp_get_max_threads();
+    size_t counts[nbr_threads];
+    size_t offsets[nbr_threads];
+    struct tablo *source = NULL;
+    
+    #pragma omp parallel num_threads(nbr_threads)
+    {
+        int thread = omp_get_thread_num();
+        int nbr_used = omp_get_num_threads();
+        size_t start = first + (last - first) * thread / nbr_used;
+        size_t end = first + (last - first) * (thread + 1) / nbr_used;
+        
+        // Un entier commencé dans la plage précédente appartient au thread précédent
+        if (start > 0 && !isBlank(text[start - 1])) {
+            while (start < length && !isBlank(text[start])) {
+                start++;
+            }
+        }
+        
+        size_t capacity = (end > start) ? (end - start) / 8 + 16 : 16;
+        size_t count = 0;
+        long *local = malloc(capacity * sizeof(long));
+        char *p = text + start;
+        
+        while (1) {
+            while (p < text + end && isBlank(*p)) {
+                p++;
+            }
+            if (p >= text + end)
+                break;
+            
+            if (count == capacity) {
+                capacity *= 2;
+                local = realloc(local, capacity * sizeof(long));
+            }
+            p = parseLong(p, text + length, &local[count]);
+            count++;
+        }
+        
+        counts[thread] = count;
+        
+        #pragma omp barrier
+        
+        #pragma omp single
+        {
+            size_t size = 0;
+            for (int t = 0; t < nbr_used; t++) {
+                offsets[t] = size;
+                size += counts[t];
+            }
+            // La taille d'un tablo est un int
+            if (size > INT_MAX) {
+                printf("Erreur : plus de %d entiers dans le fichier\n", INT_MAX);
+                exit(1);
+            }
+            source = allocateTablo(size);
+        }
+        
+        memcpy(source->tab + offsets[thread], local, count * sizeof(long));
+        free(local);
+    }
+    
+    return source;
+}
+
+/**
+ * Charge le texte d'un fichier en mémoire : projection du fichier, ou lecture complète s'il ne peut pas être projeté
+ * @param *file fichier texte ouvert en lecture
+ * @param *length taille du texte
+ * @param *mapped 1 si le texte est projeté (munmap()), 0 s'il vient de malloc (free())
+ * @return le texte chargé
+ */
+char *loadText(FILE *file, size_t *length, int *mapped) {
+    struct stat status;
+    char *text = MAP_FAILED;
+    size_t size = 0;
+    
+    if (fstat(fileno(file), &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        size = status.st_size;
+        text = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fileno(file), 0);
+    }
+    
+    // Entrée non projetable (tube, fichier vide...) : lecture complète en mémoire
+    int isMapped = text != MAP_FAILED;
+    if (!isMapped) {
+        size_t capacity = 1 << 16;
+        size_t nbr_read;
+        text = malloc(capacity);
+        size = 0;
+        while ((nbr_read = fread(text + size, 1, capacity - size, file)) > 0) {
+            size += nbr_read;
+            if (size == capacity) {
+                capacity *= 2;
+                text = realloc(text, capacity);
+            }
+        }
+    }
+    
+    *length = size;
+    *mapped = isMapped;
+    
+    return text;
+}
+
+/**
+ * Lecture parallèle d'un fichier texte d'entiers (parseText()).
+ * Le fichier est projeté en mémoire, ou lu entièrement s'il ne peut pas l'être.
+ * @param *file fichier texte ouvert en lecture
+ * @return le tablo lu
+ */
+struct tablo *parseFileAndFillTablo(FILE *file) {
+    size_t length;
+    int mapped;
+    char *text = loadText(file, &length, &mapped);
+    
+    struct tablo *source = parseText(text, 0, length, length);
+    
+    if (mapped)
+        munmap(text, length);
+    else
+        free(text);
+    
+    return source;
+}
+
+/**
+ * Indique si le fichier commence par l'en-tête du format binaire (la position dans le fichier est conservée).
+ * Une entrée qui ne peut pas être repositionnée (tube) est toujours considérée comme du texte.
+ * @param *file fichier ouvert en lecture
+ * @return 1 si le fichier est au format binaire, 0 sinon
+ */
+int isBinaryFile(FILE *file) {
+    char magic[8];
+    long position = ftell(file);
+    
+    // Entrée non repositionnable (tube) : lue comme un fichier texte
+    if (position < 0)
+        return 0;
+    
+    int binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    
+    fseek(file, position, SEEK_SET);
+    
+    return binary;
+}
+
+/**
+ * Décode l'en-tête d'un fichier binaire
+ * @param *header en-tête lu au début du fichier
+ * @param *count nombre d'entiers du fichier
+ * @param *width taille d'un entier en octets (4 ou 8, le programme s'arrête sinon)
+ * @return 1 si l'ordre des octets du fichier est l'inverse de celui de la machine, 0 sinon
+ */
+int decodeBinaryHeader(struct binaryHeader *header, uint64_t *count, uint32_t *width) {
+    int swap = header->endianness != BINARY_ENDIANNESS;
+    *count = swap ? __builtin_bswap64(header->count) : header->count;
+    *width = swap ? __builtin_bswap32(header->width) : header->width;
+    
+    if (*width != 4 && *width != 8) {
+        printf("En-tête du fichier binaire invalide\n");
+        exit(1);
+    }
+    
+    return swap;
+}
+
+/**
+ * Lit le i-ème entier des données d'un fichier binaire
+ * @param *data début des données (après l'en-tête)
+ * @param i indice de l'entier
+ * @param width taille d'un entier en octets
+ * @param swap 1 s'il faut inverser l'ordre des octets
+ * @return l'entier lu
+ */
+long decodeBinaryValue(char *data, long i, uint32_t width, int swap) {
+    if (width == 8) {
+        uint64_t value;
+        memcpy(&value, data + i * 8, 8);
+        return (int64_t) (swap ? __builtin_bswap64(value) : value);
+    }
+    
+    uint32_t value;
+    memcpy(&value, data + i * 4, 4);
+    return (int32_t) (swap ? __builtin_bswap32(value) : value);
+}
+
+/**
+ * Charge un fichier binaire par projection mémoire. Si les entiers sont des long dans l'ordre des octets de la machine,
+ * 'tab' pointe directement dans la projection (aucune copie), sinon ils sont convertis en parallèle dans un tablo alloué.
+ * @param *file fichier binaire ouvert en lecture
+ * @return le tablo lu
+ */
+struct tablo *loadBinaryTablo(FILE *file) {
+    struct stat status;
+    
+    if (fstat(fileno(file), &status) != 0 || (size_t) status.st_size < sizeof(struct binaryHeader)) {
+        printf("Erreur sur la lecture du fichier binaire\n");
+        exit(1);
+    }
+    
+    char *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fileno(file), 0);
+    
+    if (mapping == MAP_FAILED) {
+        printf("Erreur sur la projection du fichier binaire\n");
+        exit(1);
+    }
+    
+    uint64_t count;
+    uint32_t width;
+    int swap = decodeBinaryHeader((struct binaryHeader *) mapping, &count, &width);
+    
+    if (count > INT_MAX || count * width > status.st_size - sizeof(struct binaryHeader)) {
+        printf("En-tête du fichier binaire invalide\n");
+        exit(1);
+    }
+    
+    char *data = mapping + sizeof(struct binaryHeader);
+    
+    // Cas sans copie : le tablo utilise directement la projection
+    if (width == sizeof(long) && !swap) {
+        struct tablo *source = malloc(sizeof(struct tablo));
+        source->tab = (long *) data;
+        source->size = count;
+        source->mapping = mapping;
+        source->arena = NULL;
+        source->mappingSize = status.st_size;
+        
+        return source;
+    }
+    
+    struct tablo *source = allocateTablo(count);
+    
+    #pragma omp parallel for
+    for (int i = 0; i < source->size; i++) {
+        source->tab[i] = decodeBinaryValue(data, i, width, swap);
+    }
+    
+    munmap(mapping, status.st_size);
+    
+    return source;
+}
+
+/**
+ * Écrit un tablo au format binaire (entiers long dans l'ordre des octets de la machine)
+ * @param *source tablo à écrire
+ * @param *path chemin du fichier créé
+ * @return void
+ */
+void writeBinaryTablo(struct tablo *source, char *path) {
+    FILE *file = fopen(path, "wb");
+    
+    if (file == NULL) {
+        printf("Erreur sur l'ouverture du fichier\n");
+        exit(1);
+    }
+    
+    struct binaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.count = source->size;
+    header.width = sizeof(long);
+    header.endianness = BINARY_ENDIANNESS;
+    
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(source->tab, sizeof(long), source->size, file) != (size_t) source->size) {
+        printf("Erreur sur l'écriture du fichier binaire\n");
+        exit(1);
+    }
+    
+    fclose(file);
+}
+
+/**
+ * Lit un tablo en détectant son format (binaire ou texte)
+ * @param *file fichier ouvert en lecture
+ * @return le tablo lu
+ */
+struct tablo *readTablo(FILE *file) {
+    if (isBinaryFile(file))
+        return loadBinaryTablo(file);
+    
+    return parseFileAndFillTablo(file);
+}
+
+/**
+ * Lecture d'un fichier (texte ou binaire) par blocs d'entiers, sans le charger entièrement en mémoire
+ */
+struct reader {
+    FILE *file;
+    int binary;
+    int swap; // Format binaire : ordre des octets inversé
+    uint32_t width; // Format binaire : taille d'un entier
+    uint64_t count; // Format binaire : nombre total d'entiers
+    uint64_t remaining; // Format binaire : nombre d'entiers restant à lire
+    char *buffer; // Format texte : octets lus mais pas encore analysés
+    size_t position;
+    size_t length;
+    int eof;
+};
+
+/**
+ * Prépare la lecture par blocs d'un fichier depuis son début
+ * @param *reader lecteur à initialiser
+ * @param *file fichier ouvert en lecture
+ * @return void
+ */
+void openReader(struct reader *reader, FILE *file) {
+    reader->file = file;
+    reader->binary = isBinaryFile(file);
+    reader->position = 0;
+    reader->length = 0;
+    reader->eof = 0;
+    reader->buffer = NULL;
+    
+    if (reader->binary) {
+        struct binaryHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1) {
+            printf("Erreur sur la lecture du fichier binaire\n");
+            exit(1);
+        }
+        reader->swap = decodeBinaryHeader(&header, &reader->count, &reader->width);
+        reader->remaining = reader->count;
+    } else {
+        reader->buffer = malloc(READER_BUFFER);
+    }
+}
+
+void closeReader(struct reader *reader) {
+    free(reader->buffer);
+}
+
+/**
+ * Position dans le fichier du prochain entier à lire
+ * @param *reader lecteur
+ * @return la position en octets
+ */
+long tellReader(struct reader *reader) {
+    return ftell(reader->file) - (long) (reader->length - reader->position);
+}
+
+/**
+ * Reprend la lecture à une position obtenue avec tellReader()
+ * @param *reader lecteur
+ * @param position position en octets
+ * @param index indice dans le tablo complet de l'entier à cette position
+ * @return void
+ */
+void seekReader(struct reader *reader, long position, long index) {
+    fseek(reader->file, position, SEEK_SET);
+    reader->position = 0;
+    reader->length = 0;
+    reader->eof = 0;
+    reader->remaining = reader->count - index;
+}
+
+/**
+ * Recharge le tampon d'un lecteur texte en conservant les octets non analysés
+ * @param *reader lecteur texte
+ * @return le nombre d'octets lus (0 en fin de fichier)
+ */
+size_t refillReader(struct reader *reader) {
+    memmove(reader->buffer, reader->buffer + reader->position, reader->length - reader->position);
+    reader->length -= reader->position;
+    reader->position = 0;
+    
+    size_t nbr_read = fread(reader->buffer + reader->length, 1, READER_BUFFER - reader->length, reader->file);
+    reader->length += nbr_read;
+    if (nbr_read == 0)
+        reader->eof = 1;
+    
+    return nbr_read;
+}
+
+/**
+ * Lit le bloc d'entiers suivant
+ * @param *reader lecteur
+ * @param *values tableau qui reçoit les entiers
+ * @param capacity nombre maximal d'entiers à lire
+ * @return le nombre d'entiers lus (0 en fin de fichier)
+ */
+int readBlock(struct reader *reader, long *values, int capacity) {
+    if (reader->binary) {
+        int count = (reader->remaining < (uint64_t) capacity) ? (int) reader->remaining : capacity;
+        count = fread(values, reader->width, count, reader->file);
+        reader->remaining -= count;
+        
+        // Conversion en place : de la fin vers le début pour les entiers de 4 octets
+        for (int i = count - 1; i >= 0; i--) {
+            values[i] = decodeBinaryValue((char *) values, i, reader->width, reader->swap);
+        }
+        
+        return count;
+    }
+    
+    int count = 0;
+    
+    while (count < capacity) {
+        while (reader->position < reader->length && isBlank(reader->buffer[reader->position])) {
+            reader->position++;
+        }
+        if (reader->position == reader->length) {
+            if (refillReader(reader) == 0)
+                break;
+            continue;
+        }
+        
+        size_t end = reader->position;
+        while (end < reader->length && !isBlank(reader->buffer[end])) {
+            end++;
+        }
+        // Entier coupé par la fin du tampon
+        if (end == reader->length && !reader->eof) {
+            refillReader(reader);
+            continue;
+        }
+        
+        parseLong(reader->buffer + reader->position, reader->buffer + end, &values[count]);
+        reader->position = end;
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ * Écriture en base 10 d'un entier long (même résultat que printf("%ld"))
+ * @param *text position où écrire l'entier (au moins 20 caractères libres)
+ * @param value entier à écrire
+ * @return la position qui suit l'entier écrit
+ */
+char *formatLong(char *text, long value) {
+    char digits[20];
+    int count = 0;
+    // Valeur absolue en non signé : -LONG_MIN ne tient pas dans un long
+    unsigned long nb = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+    
+    if (value < 0)
+        *text++ = '-';
+    
+    do {
+        digits[count++] = '0' + nb % 10;
+        nb /= 10;
+    } while (nb > 0);
+    
+    while (count > 0) {
+        *text++ = digits[--count];
+    }
+    
+    return text;
+}
+
+/**
+ * Écriture du résultat par grands blocs de WRITER_BUFFER octets au lieu d'un printf() par entier
+ */
+struct writer {
+    FILE *file;
+    char *buffer;
+    size_t length;
+};
+
+void openWriter(struct writer *writer, FILE *file) {
+    writer->file = file;
+    writer->buffer = malloc(WRITER_BUFFER);
+    writer->length = 0;
+}
+
+/**
+ * Écrit le contenu du tampon dans le fichier
+ * @param *writer écrivain
+ * @return void
+ */
+void flushWriter(struct writer *writer) {
+    fwrite(writer->buffer, 1, writer->length, writer->file);
+    writer->length = 0;
+}
+
+/**
+ * Ajoute un entier au tampon, précédé d'un séparateur s'il n'est pas nul
+ * @param *writer écrivain
+ * @param separator caractère écrit avant l'entier (0 pour aucun)
+ * @param value entier à écrire
+ * @return void
+ */
+void writeLong(struct writer *writer, char separator, long value) {
+    // Séparateur, signe et 19 chiffres au plus
+    if (writer->length + 21 > WRITER_BUFFER)
+        flushWriter(writer);
+    
+    if (separator != 0)
+        writer->buffer[writer->length++] = separator;
+    writer->length = formatLong(writer->buffer + writer->length, value) - writer->buffer;
+}
+
+/**
+ * Termine la ligne, écrit le tampon et le libère
+ * @param *writer écrivain
+ * @return void
+ */
+void closeWriter(struct writer *writer) {
+    if (writer->length + 1 > WRITER_BUFFER)
+        flushWriter(writer);
+    writer->buffer[writer->length++] = '\n';
+    flushWriter(writer);
+    fflush(writer->file);
+    free(writer->buffer);
+}
+
+/**
+ Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 20 du .pdf)
+ */
+void up(struct tablo *source, struct tablo *dest) {
+    // Copie du tablo initial à la fin du nouveau tablo
+    #pragma omp parallel for
+    for (int i = 0; i < source->size; i++) {
+        dest->tab[i + source->size] = source->tab[i];
+    }
+    
+    // Algorithme de montée
+    for (int i = log2(source->size) - 1; i >= 0; i--) {
+        int first = pow(2, i);
+        #pragma omp parallel for
+        for (int j = 0; j < first; j += KERNEL_BLOCK) {
+            int count = (first - j < KERNEL_BLOCK) ? first - j : KERNEL_BLOCK;
+            kernels.pairs(dest->tab + first + j, dest->tab + 2 * (first + j), count, SCAN_SUM);
+        }
+    }
+}
+
+/**
+ Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 21 du .pdf)
+ */
+void down(struct tablo *a, struct tablo *b) {
+    b->tab[1] = 0; // Élément neutre de la somme
+    
+    // Algorithme de descente préfixe
+    for (int i = 1; i <= log2(a->size / 2); i++) {
+        int first = pow(2, i);
+        int parents = first / 2;
+        #pragma omp parallel for
+        for (int m = 0; m < parents; m += KERNEL_BLOCK) {
+            int count = (parents - m < KERNEL_BLOCK) ? parents - m : KERNEL_BLOCK;
+            kernels.spread(b->tab + first + 2 * m, b->tab + parents + m, a->tab + first + 2 * m, count, SCAN_SUM, SCAN_PREFIX);
+        }
+    }
+}
+
+/**
+ Même principe que la méthode down() mais on parcourt le tablo à l'envers en adaptant aussi les indices
+ */
+void downSuffix(struct tablo *a, struct tablo *b) {
+    b->tab[1] = 0;
+    
+    // Algorithme de descente suffixe
+    for (int i = 1; i <= log2(a->size / 2); i++) {
+        int first = pow(2, i);
+        int parents = first / 2;
+        #pragma omp parallel for
+        for (int m = 0; m < parents; m += KERNEL_BLOCK) {
+            int count = (parents - m < KERNEL_BLOCK) ? parents - m : KERNEL_BLOCK;
+            kernels.spread(b->tab + first + 2 * m, b->tab + parents + m, a->tab + first + 2 * m, count, SCAN_SUM, SCAN_SUFFIX);
+        }
+    }
+}
+
+/**
+ Même principe que la méthode up() mais on applique le max au lieu de la somme
+ */
+void upMax(struct tablo *source, struct tablo *dest) {
+    // Copie du tablo initial à la fin du nouveau tablo
+    #pragma omp parallel for
+    for (int i = 0; i < source->size; i++) {
+        dest->tab[i + source->size] = source->tab[i];
+    }
+    
+    // Algorithme de montée
+    for (int i = log2(source->size) - 1; i >= 0; i--) {
+        int first = pow(2, i);
+        #pragma omp parallel for
+        for (int j = 0; j < first; j += KERNEL_BLOCK) {
+            int count = (first - j < KERNEL_BLOCK) ? first - j : KERNEL_BLOCK;
+            kernels.pairs(dest->tab + first + j, dest->tab + 2 * (first + j), count, SCAN_MAX);
+        }
+    }
+}
+
+/**
+ Même principe que la méthode down() mais on applique le max au lieu de la somme
+ */
+void downMax(struct tablo *a, struct tablo *b) {
+    b->tab[1] = LONG_MIN; // Élément neutre du max des entiers long
+    
+    // Algorithme de descente préfixe max
+    for (int i = 1; i <= log2(a->size / 2); i++) {
+        int first = pow(2, i);
+        int parents = first / 2;
+        #pragma omp parallel for
+        for (int m = 0; m < parents; m += KERNEL_BLOCK) {
+            int count = (parents - m < KERNEL_BLOCK) ? parents - m : KERNEL_BLOCK;
+            kernels.spread(b->tab + first + 2 * m, b->tab + parents + m, a->tab + first + 2 * m, count, SCAN_MAX, SCAN_PREFIX);
+        }
+    }
+}
+
+/**
+ Même principe que la méthode downSuffixe() mais on applique le max au lieu de la somme
+ */
+void downMaxSuffix(struct tablo *a, struct tablo *b) {
+    b->tab[1] = LONG_MIN; // Élément neutre du max des entiers long
+    
+    // Algorithme de descente suffixe max
+    for (int i = 1; i <= log2(a->size / 2); i++) {
+        int first = pow(2, i);
+        int parents = first / 2;
+        #pragma omp parallel for
+        for (int m = 0; m < parents; m += KERNEL_BLOCK) {
+            int count = (parents - m < KERNEL_BLOCK) ? parents - m : KERNEL_BLOCK;
+            kernels.spread(b->tab + first + 2 * m, b->tab + parents + m, a->tab + first + 2 * m, count, SCAN_MAX, SCAN_SUFFIX);
+        }
+    }
+}
+
+/**
+ Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 23 du .pdf)
+ */
+void final(struct tablo *a, struct tablo *b) {
+    int first = pow(2, log2(a->size / 2));
+    int max = pow(2, log2(a->size / 2) + 1);
+    #pragma omp parallel for
+    for (int i = first; i < max; i += KERNEL_BLOCK) {
+        int count = (max - i < KERNEL_BLOCK) ? max - i : KERNEL_BLOCK;
+        kernels.elements(b->tab + i, a->tab + i, count, SCAN_SUM);
+    }
+}
+
+/**
+ Même principe que la méthode final() mais on applique le max au lieu de la somme
+ */
+void finalMax(struct tablo *a, struct tablo *b) {
+    int first = pow(2, log2(a->size / 2));
+    int max = pow(2, log2(a->size / 2) + 1);
+    #pragma omp parallel for
+    for (int i = first; i < max; i += KERNEL_BLOCK) {
+        int count = (max - i < KERNEL_BLOCK) ? max - i : KERNEL_BLOCK;
+        kernels.elements(b->tab + i, a->tab + i, count, SCAN_MAX);
+    }
+}
+
+/**
+ * Calcule la somme préfixe d'un tablo avec l'arbre de réduction du cours (up, down, final)
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @param *arena arène des deux tablos de l'arbre, libérés à la fin du calcul
+ * @return void
+ */
+void prefixSumTree(struct tablo *source, struct tablo *dest, struct arena *arena) {
+    size_t mark = markArena(arena);
+    struct tablo *a = arenaTablo(arena, source->size * 2);
+    
+    up(source, a);
+    
+    struct tablo *b = arenaTablo(arena, source->size * 2);
+    
+    down(a, b);
+    final(a, b);
+    
+    // Copie du résultat dans le tablo 'dest'
+    #pragma omp parallel for
+    for (int i = 0; i < dest->size; i++) {
+        dest->tab[i] = b->tab[i + source->size];
+    }
+    
+    releaseArena(arena, mark);
+}
+
+/**
+ * Calcule la somme suffixe d'un tablo avec l'arbre de réduction du cours (up, downSuffix, final)
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @param *arena arène des deux tablos de l'arbre, libérés à la fin du calcul
+ * @return void
+ */
+void suffixSumTree(struct tablo *source, struct tablo *dest, struct arena *arena) {
+    size_t mark = markArena(arena);
+    struct tablo *a = arenaTablo(arena, source->size * 2);
+    
+    up(source, a);
+    
+    struct tablo *b = arenaTablo(arena, source->size * 2);
+    
+    downSuffix(a, b);
+    final(a, b);
+    
+    // Copie du résultat dans le tablo 'dest'
+    #pragma omp parallel for
+    for (int i = 0; i < dest->size; i++) {
+        dest->tab[i] = b->tab[i + source->size];
+    }
+    
+    releaseArena(arena, mark);
+}
+
+/**
+ * Calcule le max suffixe d'un tablo avec l'arbre de réduction du cours (upMax, downMaxSuffix, finalMax)
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @param *arena arène des deux tablos de l'arbre, libérés à la fin du calcul
+ * @return void
+ */
+void suffixMaxTree(struct tablo *source, struct tablo *dest, struct arena *arena) {
+    size_t mark = markArena(arena);
+    struct tablo *a = arenaTablo(arena, source->size * 2);
+    
+    upMax(source, a);
+    
+    struct tablo *b = arenaTablo(arena, source->size * 2);
+    
+    downMaxSuffix(a, b);
+    finalMax(a, b);
+    
+    // Copie du résultat dans le tablo 'dest'
+    #pragma omp parallel for
+    for (int i = 0; i < dest->size; i++) {
+        dest->tab[i] = b->tab[i + source->size];
+    }
+    
+    releaseArena(arena, mark);
+}
+
+/**
+ * Calcule le max préfixe d'un tablo avec l'arbre de réduction du cours (upMax, downMax, finalMax)
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @param *arena arène des deux tablos de l'arbre, libérés à la fin du calcul
+ * @return void
+ */
+void prefixMaxTree(struct tablo *source, struct tablo *dest, struct arena *arena) {
+    size_t mark = markArena(arena);
+    struct tablo *a = arenaTablo(arena, source->size * 2);
+    
+    upMax(source, a);
+    
+    struct tablo *b = arenaTablo(arena, source->size * 2);
+    
+    downMax(a, b);
+    finalMax(a, b);
+    
+    // Copie du résultat dans le tablo 'dest'
+    #pragma omp parallel for
+    for (int i = 0; i < dest->size; i++) {
+        dest->tab[i] = b->tab[i + source->size];
+    }
+    
+    releaseArena(arena, mark);
+}
+
+/**
+ * Arrête le programme sur un dépassement de capacité (version checked)
+ * @return void
+ */
+void overflowError(void) {
+    printf("Erreur : dépassement de capacité des sommes\n");
+    exit(1);
+}
+
+long checkedAdd(long a, long b) {
+    long result;
+    if (__builtin_add_overflow(a, b, &result))
+        overflowError();
+    return result;
+}
+
+long checkedSub(long a, long b) {
+    long result;
+    if (__builtin_sub_overflow(a, b, &result))
+        overflowError();
+    return result;
+}
+
+// Arithmétique des versions typées : directe (int32, int64) ou avec détection du dépassement (checked)
+#define PLAIN_ADD(a, b) ((a) + (b))
+#define PLAIN_SUB(a, b) ((a) - (b))
+#define CHECKED_ADD(a, b) checkedAdd(a, b)
+#define CHECKED_SUB(a, b) checkedSub(a, b)
+
+/**
+ * Génère le balayage (scan) inclusif par blocs contigus d'un type d'entiers T : scan##NAME(source, dest, size,
+ * operator, direction). Chaque thread balaie son bloc, on combine ensuite les retenues des blocs qui le précèdent
+ * (ou le suivent pour un suffixe), puis chaque thread corrige son bloc avec cette retenue. Seules les retenues
+ * (une par thread) sont allouées en plus du résultat ; 'dest' peut être 'source' pour un calcul en place.
+ * MIN est l'élément neutre du max pour T, ADD l'addition utilisée.
+ */
+#define DEFINE_SCAN(T, NAME, MIN, ADD) \
+void scan##NAME(T *source, T *dest, int size, int operator, int direction) { \
+    int nbr_threads = omp_get_max_threads(); \
+    T carries[nbr_threads]; \
+    T neutral = (operator == SCAN_SUM) ? 0 : MIN; /* Élément neutre de l'opérateur */ \
+    \
+    _Pragma("omp parallel num_threads(nbr_threads)") \
+    { \
+        int thread = omp_get_thread_num(); \
+        int nbr_used = omp_get_num_threads(); \
+        int start = (long) size * thread / nbr_used; \
+        int end = (long) size * (thread + 1) / nbr_used; \
+        T acc = neutral; \
+        \
+        /* Étape 1 : balayage local du bloc */ \
+        if (direction == SCAN_PREFIX && operator == SCAN_SUM) { \
+            for (int i = start; i < end; i++) { \
+                acc = ADD(acc, source[i]); \
+                dest[i] = acc; \
+            } \
+        } else if (direction == SCAN_PREFIX) { \
+            for (int i = start; i < end; i++) { \
+                acc = (source[i] > acc) ? source[i] : acc; \
+                dest[i] = acc; \
+            } \
+        } else if (operator == SCAN_SUM) { \
+            for (int i = end - 1; i >= start; i--) { \
+                acc = ADD(acc, source[i]); \
+                dest[i] = acc; \
+            } \
+        } else { \
+            for (int i = end - 1; i >= start; i--) { \
+                acc = (source[i] > acc) ? source[i] : acc; \
+                dest[i] = acc; \
+            } \
+        } \
+        carries[thread] = acc; \
+        \
+        _Pragma("omp barrier") \
+        \
+        /* Étape 2 : retenue des blocs précédents (préfixe) ou suivants (suffixe) */ \
+        int first = (direction == SCAN_PREFIX) ? 0 : thread + 1; \
+        int last = (direction == SCAN_PREFIX) ? thread : nbr_used; \
+        T carry = neutral; \
+        for (int t = first; t < last; t++) { \
+            if (operator == SCAN_SUM) \
+                carry = ADD(carry, carries[t]); \
+            else \
+                carry = (carries[t] > carry) ? carries[t] : carry; \
+        } \
+        \
+        /* Étape 3 : correction du bloc */ \
+        if (carry != neutral && operator == SCAN_SUM) { \
+            for (int i = start; i < end; i++) { \
+                dest[i] = ADD(dest[i], carry); \
+            } \
+        } else if (carry != neutral) { \
+            for (int i = start; i < end; i++) { \
+                dest[i] = (carry > dest[i]) ? carry : dest[i]; \
+            } \
+        } \
+    } \
+}
+
+/**
+ * Génère findSegment##NAME(M, size, max, start, end) pour des valeurs de M de type T : cherche la valeur maximale
+ * de M, son premier indice et la fin de la suite d'indices où M garde cette valeur.
+ * À partir de SEGMENT_PARALLEL valeurs, chaque thread cherche le maximum (et son premier indice) de son bloc
+ * contigu, puis les maxima des blocs sont combinés dans l'ordre. La fin est d'abord cherchée séquentiellement
+ * sur SEGMENT_PARALLEL valeurs ; si la sous-séquence est plus longue, chaque thread cherche la première valeur
+ * différente du maximum dans son bloc du reste de M et on garde la plus petite.
+ */
+#define DEFINE_FIND_SEGMENT(T, NAME, MIN) \
+void findSegment##NAME(T *M, int size, long *max, int *start, int *end) { \
+    int nbr_threads = omp_get_max_threads(); \
+    long maxima[nbr_threads]; \
+    int indices[nbr_threads]; \
+    int nbr_used = 1; \
+    \
+    /* On cherche la valeur maximale et son premier index dans chaque bloc */ \
+    _Pragma("omp parallel num_threads(nbr_threads) if (size >= SEGMENT_PARALLEL)") \
+    { \
+        int thread = omp_get_thread_num(); \
+        int first = (long) size * thread / omp_get_num_threads(); \
+        int last = (long) size * (thread + 1) / omp_get_num_threads(); \
+        T best = MIN; \
+        int index = first; \
+        \
+        for (int i = first; i < last; i++) { \
+            if (best < M[i]) { \
+                best = M[i]; \
+                index = i; \
+            } \
+        } \
+        /* Un bloc vide ne doit pas donner le minimum de T comme maximum */ \
+        maxima[thread] = (first < last) ? (long) best : LONG_MIN; \
+        indices[thread] = index; \
+        \
+        if (thread == 0) \
+            nbr_used = omp_get_num_threads(); \
+    } \
+    \
+    /* Les blocs sont dans l'ordre : le premier bloc qui atteint le maximum donne le premier index */ \
+    *max = LONG_MIN; \
+    *start = 0; \
+    for (int t = 0; t < nbr_used; t++) { \
+        if (*max < maxima[t]) { \
+            *max = maxima[t]; \
+            *start = indices[t]; \
+        } \
+    } \
+    \
+    *end = *start; \
+    int probe = (size - *start < SEGMENT_PARALLEL) ? size : *start + SEGMENT_PARALLEL; \
+    while (*end < probe && M[*end] == *max) { \
+        (*end)++; \
+    } \
+    if (*end < probe || *end == size) \
+        return; \
+    \
+    /* Longue sous-séquence : première valeur différente du maximum dans chaque bloc du reste de M */ \
+    int from = *end; \
+    int stop = size; \
+    _Pragma("omp parallel num_threads(nbr_threads) reduction(min:stop)") \
+    { \
+        int thread = omp_get_thread_num(); \
+        int first = from + (long) (size - from) * thread / omp_get_num_threads(); \
+        int last = from + (long) (size - from) * (thread + 1) / omp_get_num_threads(); \
+        \
+        for (int i = first; i < last; i++) { \
+            if (M[i] != *max) { \
+                stop = i; \
+                break; \
+            } \
+        } \
+    } \
+    *end = stop; \
+}
+
+// Versions 32 bits, 64 bits et 64 bits avec détection du dépassement (la version checked cherche M comme int64)
+DEFINE_SCAN(int32_t, Int32, INT32_MIN, PLAIN_ADD)
+DEFINE_SCAN(long, Int64, LONG_MIN, PLAIN_ADD)
+DEFINE_SCAN(long, Checked, LONG_MIN, CHECKED_ADD)
+DEFINE_FIND_SEGMENT(int32_t, Int32, INT32_MIN)
+DEFINE_FIND_SEGMENT(long, Int64, LONG_MIN)
+
+/**
+ * Balayage (scan) inclusif par blocs contigus d'un tablo (scanInt64())
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat (peut être 'source' pour un calcul en place)
+ * @param operator SCAN_SUM ou SCAN_MAX
+ * @param direction SCAN_PREFIX ou SCAN_SUFFIX
+ * @return void
+ */
+void scan(struct tablo *source, struct tablo *dest, int operator, int direction) {
+    scanInt64(source->tab, dest->tab, source->size, operator, direction);
+}
+
+/**
+ * Calcule la somme préfixe d'un tablo
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @return void
+ */
+void prefixSum(struct tablo *source, struct tablo *dest) {
+    scan(source, dest, SCAN_SUM, SCAN_PREFIX);
+}
+
+/**
+ * Calcule la somme suffixe d'un tablo
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @return void
+ */
+void suffixSum(struct tablo *source, struct tablo *dest) {
+    scan(source, dest, SCAN_SUM, SCAN_SUFFIX);
+}
+
+/**
+ * Calcule le max suffixe d'un tablo
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @return void
+ */
+void suffixMax(struct tablo *source, struct tablo *dest) {
+    scan(source, dest, SCAN_MAX, SCAN_SUFFIX);
+}
+
+/**
+ * Calcule le max préfixe d'un tablo
+ * @param *source tablo de référence pour le calcul
+ * @param *dest tablo résultat
+ * @return void
+ */
+void prefixMax(struct tablo *source, struct tablo *dest) {
+    scan(source, dest, SCAN_MAX, SCAN_PREFIX);
+}
+
+/**
+ * Calcule directement le tablo M (Étape 5) sans construire PSUM, SSUM, SMAX et PMAX.
+ * Une première passe résume chaque bloc de FUSED_BLOCK entiers (somme, max des sommes préfixes et suffixes locales),
+ * les résumés sont balayés pour obtenir les retenues de chaque bloc, puis une seconde passe reconstruit
+ * PSUM / SMAX (de droite à gauche) et SSUM / PMAX (de gauche à droite) dans le bloc, qui tient en cache.
+ * @param *source tablo de référence pour le calcul
+ * @param *M tablo résultat
+ * @return void
+ */
+void fusedMaximum(struct tablo *source, struct tablo *M) {
+    int nbr_blocks = (source->size + FUSED_BLOCK - 1) / FUSED_BLOCK;
+
+    struct tablo *total = allocateTablo(nbr_blocks);
+    struct tablo *prefix = allocateTablo(nbr_blocks); // Puis max de PSUM sur les blocs suivants
+    struct tablo *suffix = allocateTablo(nbr_blocks); // Puis max de SSUM sur les blocs précédents
+    struct tablo *before = allocateTablo(nbr_blocks); // Somme des blocs précédents
+    struct tablo *after = allocateTablo(nbr_blocks); // Somme des blocs suivants
+
+    // Première passe : résumé de chaque bloc
+    #pragma omp parallel for
+    for (int b = 0; b < nbr_blocks; b++) {
+        int start = b * FUSED_BLOCK;
+        int end = (start + FUSED_BLOCK < source->size) ? start + FUSED_BLOCK : source->size;
+        long sum = 0;
+        long max = LONG_MIN;
+        long min = 0; // Plus petite somme préfixe exclusive
+
+        for (int i = start; i < end; i++) {
+            min = (sum < min) ? sum : min;
+            sum += source->tab[i];
+            max = (sum > max) ? sum : max;
+        }
+
+        total->tab[b] = sum;
+        prefix->tab[b] = max;
+        suffix->tab[b] = sum - min;
+    }
+
+    // Retenues de chaque bloc
+    prefixSum(total, before);
+    suffixSum(total, after);
+
+    #pragma omp parallel for
+    for (int b = 0; b < nbr_blocks; b++) {
+        before->tab[b] -= total->tab[b];
+        after->tab[b] -= total->tab[b];
+        prefix->tab[b] += before->tab[b];
+        suffix->tab[b] += after->tab[b];
+    }
+
+    suffixMax(prefix, prefix);
+    prefixMax(suffix, suffix);
+
+    // Seconde passe : calcul de M bloc par bloc
+    #pragma omp parallel for
+    for (int b = 0; b < nbr_blocks; b++) {
+        int start = b * FUSED_BLOCK;
+        int end = (start + FUSED_BLOCK < source->size) ? start + FUSED_BLOCK : source->size;
+
+        // SMAX - PSUM + Q, de droite à gauche
+        long psum = before->tab[b] + total->tab[b];
+        long smax = (b + 1 < nbr_blocks) ? prefix->tab[b + 1] : LONG_MIN;
+        for (int i = end - 1; i >= start; i--) {
+            smax = (psum > smax) ? psum : smax;
+            M->tab[i] = smax - psum + source->tab[i];
+            psum -= source->tab[i];
+        }
+
+        // PMAX - SSUM, de gauche à droite
+        long ssum = after->tab[b] + total->tab[b];
+        long pmax = (b > 0) ? suffix->tab[b - 1] : LONG_MIN;
+        for (int i = start; i < end; i++) {
+            pmax = (ssum > pmax) ? ssum : pmax;
+            M->tab[i] += pmax - ssum;
+            ssum -= source->tab[i];
+        }
+    }
+
+    freeTablo(total);
+    freeTablo(prefix);
+    freeTablo(suffix);
+    freeTablo(before);
+    freeTablo(after);
+}
+
+/**
+ * Résumé fusionnable d'une suite d'entiers : somme totale, meilleure somme préfixe, suffixe et meilleure sous-séquence,
+ * avec leurs indices (inclusifs) dans le tablo complet. À somme égale, on garde la sous-séquence qui commence le plus tôt,
+ * puis la plus courte, ce qui rend le résultat indépendant du découpage en blocs.
+ */
+struct summary {
+    long size; // Nombre d'entiers résumés (0 : résumé vide, élément neutre de mergeSummaries())
+    long total;
+    long prefix;
+    long prefixEnd;
+    long suffix;
+    long suffixStart;
+    long best;
+    long bestStart;
+    long bestEnd;
+};
+
+/**
+ * Résume séquentiellement une suite d'entiers
+ * @param *values entiers à résumer
+ * @param count nombre d'entiers
+ * @param offset indice du premier entier dans le tablo complet
+ * @return le résumé
+ */
+struct summary summarizeRange(long *values, int count, long offset) {
+    struct summary result = { count, 0, LONG_MIN, -1, LONG_MIN, -1, LONG_MIN, -1, -1 };
+    long min = 0; // Plus petite somme préfixe exclusive
+    long minIndex = offset;
+    long current = 0; // Meilleure somme qui se termine sur l'entier courant
+    long currentStart = offset;
+    
+    for (int i = 0; i < count; i++) {
+        if (result.total < min) {
+            min = result.total;
+            minIndex = offset + i;
+        }
+        result.total += values[i];
+        if (result.total > result.prefix) {
+            result.prefix = result.total;
+            result.prefixEnd = offset + i;
+        }
+        
+        if (i == 0 || current < 0) {
+            current = values[i];
+            currentStart = offset + i;
+        } else {
+            current += values[i];
+        }
+        if (current > result.best || (current == result.best && currentStart < result.bestStart)) {
+            result.best = current;
+            result.bestStart = currentStart;
+            result.bestEnd = offset + i;
+        }
+    }
+    
+    result.suffix = result.total - min;
+    result.suffixStart = minIndex;
+    
+    return result;
+}
+
+/**
+ * Fusionne les résumés de deux suites consécutives
+ * @param left résumé de la suite de gauche
+ * @param right résumé de la suite de droite
+ * @return le résumé de la concaténation
+ */
+struct summary mergeSummaries(struct summary left, struct summary right) {
+    if (left.size == 0)
+        return right;
+    if (right.size == 0)
+        return left;
+    
+    struct summary result = left;
+    result.size = left.size + right.size;
+    result.total = left.total + right.total;
+    
+    if (left.total + right.prefix > left.prefix) {
+        result.prefix = left.total + right.prefix;
+        result.prefixEnd = right.prefixEnd;
+    }
+    
+    result.suffix = right.suffix;
+    result.suffixStart = right.suffixStart;
+    if (left.suffix + right.total >= right.suffix) {
+        result.suffix = left.suffix + right.total;
+        result.suffixStart = left.suffixStart;
+    }
+    
+    // Candidats dans l'ordre des débuts : à égalité, on garde le premier rencontré le plus tôt
+    long across = left.suffix + right.prefix;
+    if (across > result.best || (across == result.best && left.suffixStart < result.bestStart)) {
+        result.best = across;
+        result.bestStart = left.suffixStart;
+        result.bestEnd = right.prefixEnd;
+    }
+    if (right.best > result.best) {
+        result.best = right.best;
+        result.bestStart = right.bestStart;
+        result.bestEnd = right.bestEnd;
+    }
+    
+    return result;
+}
+
+/**
+ * Résume en parallèle une suite d'entiers : chaque thread résume un bloc contigu, puis les résumés sont fusionnés dans l'ordre
+ * @param *values entiers à résumer
+ * @param count nombre d'entiers
+ * @param offset indice du premier entier dans le tablo complet
+ * @return le résumé
+ */
+struct summary summarize(long *values, int count, long offset) {
+    int nbr_threads = omp_get_max_threads();
+    struct summary summaries[nbr_threads];
+    struct summary result = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    int nbr_used = 1;
+    
+    #pragma omp parallel num_threads(nbr_threads)
+    {
+        int thread = omp_get_thread_num();
+        int start = (long) count * thread / omp_get_num_threads();
+        int end = (long) count * (thread + 1) / omp_get_num_threads();
+        
+        summaries[thread] = summarizeRange(values + start, end - start, offset + start);
+        
+        #pragma omp single
+        nbr_used = omp_get_num_threads();
+    }
+    
+    for (int t = 0; t < nbr_used; t++) {
+        result = mergeSummaries(result, summaries[t]);
+    }
+    
+    return result;
+}
+
+/**
+ * Calcule séquentiellement M sur une suite d'entiers à partir des retenues de ses voisines
+ * @param *values entiers de la suite
+ * @param count nombre d'entiers
+ * @param left meilleure somme d'une sous-séquence qui se termine juste avant la suite (LONG_MIN s'il n'y en a pas)
+ * @param right meilleure somme d'une sous-séquence qui commence juste après la suite (LONG_MIN s'il n'y en a pas)
+ * @param *M valeurs de M sur la suite
+ * @return void
+ */
+void rangeMaximum(long *values, int count, long left, long right, long *M) {
+    // Seule la partie positive des retenues compte : M[i] = Q[i] + max(0, gauche) + max(0, droite)
+    long gain = (left > 0) ? left : 0;
+    for (int i = 0; i < count; i++) {
+        M[i] = values[i] + gain;
+        gain = (M[i] > 0) ? M[i] : 0;
+    }
+    
+    gain = (right > 0) ? right : 0;
+    for (int i = count - 1; i >= 0; i--) {
+        M[i] += gain;
+        gain = (values[i] + gain > 0) ? values[i] + gain : 0;
+    }
+}
+
+/**
+ * Calcule M sur un bloc du tablo à partir des retenues des blocs voisins. Même découpage en blocs contigus que summarize().
+ * @param *values entiers du bloc
+ * @param count nombre d'entiers du bloc
+ * @param left meilleure somme d'une sous-séquence qui se termine juste avant le bloc (LONG_MIN s'il n'y en a pas)
+ * @param right meilleure somme d'une sous-séquence qui commence juste après le bloc (LONG_MIN s'il n'y en a pas)
+ * @param *M valeurs de M sur le bloc
+ * @return void
+ */
+void blockMaximum(long *values, int count, long left, long right, long *M) {
+    int nbr_threads = omp_get_max_threads();
+    struct summary summaries[nbr_threads];
+    
+    #pragma omp parallel num_threads(nbr_threads)
+    {
+        int thread = omp_get_thread_num();
+        int nbr_used = omp_get_num_threads();
+        int start = (long) count * thread / nbr_used;
+        int end = (long) count * (thread + 1) / nbr_used;
+        
+        summaries[thread] = summarizeRange(values + start, end - start, start);
+        
+        #pragma omp barrier
+        
+        // Retenues des blocs des autres threads
+        long before = left;
+        for (int t = 0; t < thread; t++) {
+            if (summaries[t].size > 0)
+                before = (before != LONG_MIN && before + summaries[t].total > summaries[t].suffix) ? before + summaries[t].total : summaries[t].suffix;
+        }
+        long after = right;
+        for (int t = nbr_used - 1; t > thread; t--) {
+            if (summaries[t].size > 0)
+                after = (after != LONG_MIN && after + summaries[t].total > summaries[t].prefix) ? after + summaries[t].total : summaries[t].prefix;
+        }
+        
+        rangeMaximum(values + start, end - start, before, after, M + start);
+    }
+}
+
+/**
+ * Mode --stream : calcule le même résultat que displayResult() en lisant le fichier par blocs de 'blockSize' entiers.
+ * Première lecture : un résumé par bloc (summarize()) pour obtenir la somme maximale et les retenues de chaque bloc.
+ * Seconde lecture : M est recalculé bloc par bloc (blockMaximum()) pour afficher la sous-séquence, puis la lecture s'arrête.
+ * La mémoire utilisée est de 2 * blockSize entiers plus un résumé par bloc ; le fichier doit pouvoir être relu (pas de tube).
+ * @param *file fichier ouvert en lecture
+ * @param blockSize nombre d'entiers par bloc
+ * @return void
+ */
+void streamMaximum(FILE *file, int blockSize) {
+    struct reader reader;
+    long *values = malloc(blockSize * sizeof(long));
+    long *M = malloc(blockSize * sizeof(long));
+    int capacity = 64;
+    int nbr_blocks = 0;
+    struct summary *blocks = malloc(capacity * sizeof(struct summary));
+    long *positions = malloc(capacity * sizeof(long)); // Position de chaque bloc dans le fichier
+    struct summary global = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    long offset = 0;
+    int count;
+    
+    // Première lecture : résumé de chaque bloc
+    openReader(&reader, file);
+    long position = tellReader(&reader);
+    while ((count = readBlock(&reader, values, blockSize)) > 0) {
+        if (nbr_blocks == capacity) {
+            capacity *= 2;
+            blocks = realloc(blocks, capacity * sizeof(struct summary));
+            positions = realloc(positions, capacity * sizeof(long));
+        }
+        blocks[nbr_blocks] = summarize(values, count, offset);
+        positions[nbr_blocks] = position;
+        global = mergeSummaries(global, blocks[nbr_blocks]);
+        nbr_blocks++;
+        offset += count;
+        position = tellReader(&reader);
+    }
+    
+    long max = (global.size > 0) ? global.best : LONG_MIN;
+    struct writer writer;
+    openWriter(&writer, stdout);
+    writeLong(&writer, 0, max);
+    
+    // Le premier indice où M vaut le maximum est le début de la meilleure sous-séquence (la plus à gauche)
+    int first = 0;
+    struct summary before = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    while (first < nbr_blocks && before.size + blocks[first].size <= global.bestStart) {
+        before = mergeSummaries(before, blocks[first]);
+        first++;
+    }
+    
+    // Meilleure somme préfixe des blocs qui suivent chaque bloc
+    long *right = malloc((nbr_blocks + 1) * sizeof(long));
+    struct summary after = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int b = nbr_blocks - 1; b >= first; b--) {
+        right[b] = (after.size > 0) ? after.prefix : LONG_MIN;
+        after = mergeSummaries(blocks[b], after);
+    }
+    
+    // Seconde lecture, à partir du bloc qui contient le début : affichage des entiers tant que M vaut le maximum
+    int ended = 0;
+    if (first < nbr_blocks)
+        seekReader(&reader, positions[first], before.size);
+    for (int b = first; b < nbr_blocks && !ended; b++) {
+        count = readBlock(&reader, values, blockSize);
+        blockMaximum(values, count, (before.size > 0) ? before.suffix : LONG_MIN, right[b], M);
+        
+        long start = before.size;
+        for (int i = (global.bestStart > start) ? global.bestStart - start : 0; i < count; i++) {
+            if (M[i] != max) {
+                ended = 1;
+                break;
+            }
+            writeLong(&writer, ' ', values[i]);
+        }
+        before = mergeSummaries(before, blocks[b]);
+    }
+    closeWriter(&writer);
+    
+    closeReader(&reader);
+    free(right);
+    free(positions);
+    free(blocks);
+    free(values);
+    free(M);
+}
+
+/**
+ * Lit l'entier suivant d'un fichier caractère par caractère : contrairement à readBlock(), qui remplit tout son
+ * tampon, la lecture rend la main dès que l'entier est disponible (flux continu sur un tube).
+ * @param *file fichier texte ouvert en lecture
+ * @param *value entier lu
+ * @return 1 si un entier a été lu, 0 en fin de fichier
+ */
+int readValue(FILE *file, long *value) {
+    int c = getc(file);
+    
+    while (c != EOF && isBlank(c)) {
+        c = getc(file);
+    }
+    if (c == EOF)
+        return 0;
+    
+    int negative = 0;
+    unsigned long nb = 0;
+    
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        c = getc(file);
+    }
+    while (c >= '0' && c <= '9') {
+        nb = nb * 10 + (c - '0');
+        c = getc(file);
+    }
+    
+    // Le reste du mot (caractères invalides) est ignoré, comme avec parseLong()
+    while (c != EOF && !isBlank(c)) {
+        c = getc(file);
+    }
+    
+    *value = negative ? -nb : nb;
+    
+    return 1;
+}
+
+/**
+ * File des résumés des blocs d'une fenêtre glissante, faite de deux piles pour une fusion non commutative :
+ * les blocs ajoutés vont sur 'back' (dont on garde le résumé total), les blocs retirés sont pris sur 'front'.
+ * Quand 'front' est vide, 'back' y est retournée en calculant les résumés cumulés, du plus récent au plus ancien.
+ * Chaque bloc est ainsi fusionné un nombre constant de fois (O(1) amorti par ajout et par retrait).
+ */
+struct windowQueue {
+    struct summary *front; // Blocs les plus anciens, le plus ancien au sommet
+    struct summary *frontTotal; // frontTotal[i] : résumé des blocs front[i] (le plus ancien), ..., front[0]
+    int frontCount;
+    struct summary *back; // Blocs les plus récents, le plus récent au sommet
+    struct summary backTotal; // Résumé de tous les blocs de 'back'
+    int backCount;
+};
+
+void openWindowQueue(struct windowQueue *queue, int capacity) {
+    struct summary empty = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    
+    queue->front = malloc(capacity * sizeof(struct summary));
+    queue->frontTotal = malloc(capacity * sizeof(struct summary));
+    queue->back = malloc(capacity * sizeof(struct summary));
+    queue->frontCount = 0;
+    queue->backCount = 0;
+    queue->backTotal = empty;
+}
+
+void closeWindowQueue(struct windowQueue *queue) {
+    free(queue->front);
+    free(queue->frontTotal);
+    free(queue->back);
+}
+
+/**
+ * Ajoute le résumé du bloc le plus récent
+ * @param *queue file
+ * @param block résumé du bloc
+ * @return void
+ */
+void pushBlock(struct windowQueue *queue, struct summary block) {
+    queue->back[queue->backCount++] = block;
+    queue->backTotal = mergeSummaries(queue->backTotal, block);
+}
+
+/**
+ * Retire le résumé du bloc le plus ancien
+ * @param *queue file (non vide)
+ * @return le résumé retiré
+ */
+struct summary popBlock(struct windowQueue *queue) {
+    if (queue->frontCount == 0) {
+        struct summary empty = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        struct summary total = empty;
+        
+        while (queue->backCount > 0) {
+            struct summary block = queue->back[--queue->backCount];
+            total = mergeSummaries(block, total);
+            queue->front[queue->frontCount] = block;
+            queue->frontTotal[queue->frontCount] = total;
+            queue->frontCount++;
+        }
+        queue->backTotal = empty;
+    }
+    
+    return queue->front[--queue->frontCount];
+}
+
+/**
+ * Résumé de tous les blocs de la file, du plus ancien au plus récent
+ * @param *queue file
+ * @return le résumé
+ */
+struct summary queueSummary(struct windowQueue *queue) {
+    if (queue->frontCount == 0)
+        return queue->backTotal;
+    
+    return mergeSummaries(queue->frontTotal[queue->frontCount - 1], queue->backTotal);
+}
+
+/**
+ * Résume les entiers d'indices [first, first + count[ d'un tampon circulaire
+ * @param *ring tampon circulaire (l'entier d'indice i est en ring[i % capacity])
+ * @param capacity taille du tampon
+ * @param first indice du premier entier dans le flux
+ * @param count nombre d'entiers
+ * @return le résumé
+ */
+struct summary summarizeRing(long *ring, long capacity, long first, long count) {
+    long position = first % capacity;
+    long before = (position + count <= capacity) ? count : capacity - position;
+    
+    struct summary head = summarizeRange(ring + position, (int) before, first);
+    if (before == count)
+        return head;
+    
+    return mergeSummaries(head, summarizeRange(ring, (int) (count - before), first + before));
+}
+
+/**
+ * Index des requêtes de meilleure sous-séquence sur un intervalle : arbre de résumés rangé comme l'arbre de réduction
+ * du cours (racine en 1, fils de i en 2i et 2i + 1). Chaque feuille résume QUERY_LEAF entiers consécutifs ; les
+ * feuilles en plus pour arriver à une puissance de 2 sont des résumés vides.
+ */
+struct queryIndex {
+    long *values; // Entiers du tablo indexé (non copiés)
+    int size;
+    int leaves; // Nombre de feuilles (puissance de 2)
+    struct summary *nodes; // 2 * leaves résumés, nodes[leaves + f] résume la feuille f
+};
+
+/**
+ * Construit en parallèle l'index de requêtes d'un tablo : feuilles résumées en parallèle, puis chaque niveau de
+ * l'arbre fusionné en parallèle des feuilles vers la racine (comme up())
+ * @param *source tablo à indexer (doit rester alloué tant que l'index est utilisé)
+ * @return l'index
+ */
+struct queryIndex *buildQueryIndex(struct tablo *source) {
+    struct queryIndex *index = malloc(sizeof(struct queryIndex));
+    int nbr_blocks = (source->size + QUERY_LEAF - 1) / QUERY_LEAF;
+    
+    index->values = source->tab;
+    index->size = source->size;
+    index->leaves = 1;
+    while (index->leaves < nbr_blocks) {
+        index->leaves *= 2;
+    }
+    index->nodes = malloc(2 * index->leaves * sizeof(struct summary));
+    
+    #pragma omp parallel for
+    for (int f = 0; f < index->leaves; f++) {
+        long first = (long) f * QUERY_LEAF;
+        int count = (first >= source->size) ? 0 : (source->size - first < QUERY_LEAF) ? source->size - first : QUERY_LEAF;
+        index->nodes[index->leaves + f] = summarizeRange(source->tab + first, count, first);
+    }
+    
+    for (int first = index->leaves / 2; first >= 1; first /= 2) {
+        #pragma omp parallel for
+        for (int i = first; i < 2 * first; i++) {
+            index->nodes[i] = mergeSummaries(index->nodes[2 * i], index->nodes[2 * i + 1]);
+        }
+    }
+    
+    return index;
+}
+
+void freeQueryIndex(struct queryIndex *index) {
+    free(index->nodes);
+    free(index);
+}
+
+/**
+ * Meilleure sous-séquence des entiers d'indices [left, right] : les feuilles entièrement couvertes sont combinées
+ * en remontant l'arbre (O(log n) résumés), les bouts de feuilles aux deux extrémités sont résumés directement
+ * @param *index index de requêtes
+ * @param left premier indice de l'intervalle
+ * @param right dernier indice de l'intervalle (inclus)
+ * @return le résumé de l'intervalle (bestStart et bestEnd sont des indices du tablo complet)
+ */
+struct summary queryRange(struct queryIndex *index, int left, int right) {
+    int first = left / QUERY_LEAF;
+    int last = right / QUERY_LEAF;
+    
+    if (first == last)
+        return summarizeRange(index->values + left, right - left + 1, left);
+    
+    struct summary head = summarizeRange(index->values + left, (first + 1) * QUERY_LEAF - left, left);
+    struct summary tail = summarizeRange(index->values + (long) last * QUERY_LEAF, right - last * QUERY_LEAF + 1, (long) last * QUERY_LEAF);
+    
+    // Feuilles ]first, last[ : les résumés de gauche et de droite sont accumulés séparément (fusion non commutative)
+    struct summary before = head;
+    struct summary after = tail;
+    for (int a = index->leaves + first + 1, b = index->leaves + last; a < b; a /= 2, b /= 2) {
+        if (a & 1)
+            before = mergeSummaries(before, index->nodes[a++]);
+        if (b & 1)
+            after = mergeSummaries(index->nodes[--b], after);
+    }
+    
+    return mergeSummaries(before, after);
+}
+
+/**
+ * Répond en parallèle à un lot de requêtes
+ * @param *index index de requêtes
+ * @param *queries bornes des requêtes : gauche puis droite (incluse) pour chaque requête
+ * @param nbr_queries nombre de requêtes
+ * @param *answers résumé de chaque intervalle
+ * @return void
+ */
+void answerQueries(struct queryIndex *index, long *queries, int nbr_queries, struct summary *answers) {
+    for (int q = 0; q < nbr_queries; q++) {
+        if (queries[2 * q] < 0 || queries[2 * q] > queries[2 * q + 1] || queries[2 * q + 1] >= index->size) {
+            printf("Erreur sur la requête %d : [%ld, %ld]\n", q + 1, queries[2 * q], queries[2 * q + 1]);
+            exit(1);
+        }
+    }
+    
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int q = 0; q < nbr_queries; q++) {
+        answers[q] = queryRange(index, (int) queries[2 * q], (int) queries[2 * q + 1]);
+    }
+}
+
+/**
+ * Intervalle [left, right] du tablo qui ne contient encore aucune sous-séquence choisie, avec sa meilleure sous-séquence
+ */
+struct candidate {
+    struct summary summary;
+    int left;
+    int right;
+};
+
+/**
+ * Ordre du tas des candidats : meilleure somme, puis début le plus tôt, puis fin la plus tôt
+ * @param *a premier candidat
+ * @param *b second candidat
+ * @return 1 si 'a' passe avant 'b', 0 sinon
+ */
+int candidateBefore(struct candidate *a, struct candidate *b) {
+    if (a->summary.best != b->summary.best)
+        return a->summary.best > b->summary.best;
+    if (a->summary.bestStart != b->summary.bestStart)
+        return a->summary.bestStart < b->summary.bestStart;
+    return a->summary.bestEnd < b->summary.bestEnd;
+}
+
+/**
+ * Ajoute un candidat au tas (tas binaire, meilleur candidat en 0)
+ * @param *heap tas
+ * @param *count nombre de candidats du tas
+ * @param candidate candidat à ajouter
+ * @return void
+ */
+void pushCandidate(struct candidate *heap, int *count, struct candidate candidate) {
+    int i = (*count)++;
+    
+    while (i > 0 && candidateBefore(&candidate, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = candidate;
+}
+
+/**
+ * Retire le meilleur candidat du tas
+ * @param *heap tas (non vide)
+ * @param *count nombre de candidats du tas
+ * @return le meilleur candidat
+ */
+struct candidate popCandidate(struct candidate *heap, int *count) {
+    struct candidate top = heap[0];
+    struct candidate last = heap[--(*count)];
+    int i = 0;
+    
+    while (2 * i + 1 < *count) {
+        int child = 2 * i + 1;
+        if (child + 1 < *count && candidateBefore(&heap[child + 1], &heap[child]))
+            child++;
+        if (!candidateBefore(&heap[child], &last))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    
+    return top;
+}
+
+/**
+ * Cherche les k meilleures sous-séquences disjointes : on choisit la meilleure sous-séquence du tablo, puis la
+ * meilleure des intervalles restants, etc. Le tas contient un candidat par intervalle restant ; choisir une
+ * sous-séquence découpe son intervalle en deux intervalles dont les meilleures sous-séquences sont données par
+ * l'index de requêtes. Coût : construction de l'index en O(n) (parallèle) puis O(k log n).
+ * @param *source tablo
+ * @param k nombre de sous-séquences cherchées
+ * @param *segments sous-séquences choisies, dans l'ordre (au moins k places)
+ * @return le nombre de sous-séquences trouvées (moins de k si le tablo est épuisé)
+ */
+int topSegments(struct tablo *source, int k, struct summary *segments) {
+    if (source->size == 0)
+        return 0;
+    
+    struct queryIndex *index = buildQueryIndex(source);
+    struct candidate *heap = malloc((k + 1) * sizeof(struct candidate));
+    int nbr_candidates = 0;
+    int found = 0;
+    
+    struct candidate whole = { index->nodes[1], 0, source->size - 1 };
+    pushCandidate(heap, &nbr_candidates, whole);
+    
+    while (found < k && nbr_candidates > 0) {
+        struct candidate best = popCandidate(heap, &nbr_candidates);
+        segments[found++] = best.summary;
+        
+        if (best.summary.bestStart > best.left) {
+            struct candidate before = { queryRange(index, best.left, best.summary.bestStart - 1), best.left, best.summary.bestStart - 1 };
+            pushCandidate(heap, &nbr_candidates, before);
+        }
+        if (best.summary.bestEnd < best.right) {
+            struct candidate after = { queryRange(index, best.summary.bestEnd + 1, best.right), best.summary.bestEnd + 1, best.right };
+            pushCandidate(heap, &nbr_candidates, after);
+        }
+    }
+    
+    free(heap);
+    freeQueryIndex(index);
+    
+    return found;
+}
+
+/**
+ * Version naïve de topSegments() (--naive) : à chaque étape, copie du tablo où les sous-séquences déjà choisies
+ * sont remplacées par TOP_MASK, puis résumé complet de la copie. Coût O(k n).
+ * @param *source tablo
+ * @param k nombre de sous-séquences cherchées
+ * @param *segments sous-séquences choisies, dans l'ordre (au moins k places)
+ * @return le nombre de sous-séquences trouvées
+ */
+int naiveTopSegments(struct tablo *source, int k, struct summary *segments) {
+    int found = 0;
+    
+    while (found < k) {
+        struct tablo *masked = allocateTablo(source->size);
+        
+        #pragma omp parallel for
+        for (int i = 0; i < source->size; i++) {
+            masked->tab[i] = source->tab[i];
+        }
+        for (int s = 0; s < found; s++) {
+            for (long i = segments[s].bestStart; i <= segments[s].bestEnd; i++) {
+                masked->tab[i] = TOP_MASK;
+            }
+        }
+        
+        struct summary best = summarize(masked->tab, masked->size, 0);
+        freeTablo(masked);
+        
+        // Plus aucun entier non masqué
+        if (best.size == 0 || best.best <= TOP_MASK / 2)
+            break;
+        segments[found++] = best;
+    }
+    
+    return found;
+}
+
+/**
+ * Sous-matrice : somme et lignes / colonnes de début et de fin (incluses)
+ */
+struct rectangle {
+    long sum;
+    int top;
+    int left;
+    int bottom;
+    int right;
+};
+
+/**
+ * Ordre des sous-matrices : meilleure somme, puis ligne de début, colonne de début, ligne de fin et colonne de fin
+ * les plus petites. L'ordre est total : le résultat ne dépend ni du nombre de threads ni de la transposition.
+ * @param *a première sous-matrice
+ * @param *b seconde sous-matrice
+ * @return 1 si 'a' passe avant 'b', 0 sinon
+ */
+int rectangleBefore(struct rectangle *a, struct rectangle *b) {
+    if (a->sum != b->sum)
+        return a->sum > b->sum;
+    if (a->top != b->top)
+        return a->top < b->top;
+    if (a->left != b->left)
+        return a->left < b->left;
+    if (a->bottom != b->bottom)
+        return a->bottom < b->bottom;
+    return a->right < b->right;
+}
+
+/**
+ * Sous-matrice de somme maximale en O(lignes² colonnes) : pour chaque couple (ligne de début, ligne de fin),
+ * les sommes des colonnes entre ces lignes sont accumulées avec le noyau vectoriel kernels.elements(), puis la
+ * meilleure sous-séquence de ces sommes (summarizeRange()) donne les colonnes. Les lignes de début sont réparties
+ * entre les threads (ordonnancement dynamique : la charge décroît avec la ligne de début). La matrice est transposée
+ * si elle a plus de lignes que de colonnes, pour que le facteur au carré soit la plus petite dimension.
+ * @param *matrix entiers de la matrice, ligne par ligne
+ * @param rows nombre de lignes
+ * @param columns nombre de colonnes
+ * @return la meilleure sous-matrice
+ */
+struct rectangle maximumSubmatrix(long *matrix, int rows, int columns) {
+    int transposed = rows > columns;
+    long *data = matrix;
+    
+    if (transposed) {
+        data = malloc((long) rows * columns * sizeof(long));
+        #pragma omp parallel for
+        for (int x = 0; x < columns; x++) {
+            for (int y = 0; y < rows; y++) {
+                data[(long) x * rows + y] = matrix[(long) y * columns + x];
+            }
+        }
+        int tmp = rows;
+        rows = columns;
+        columns = tmp;
+    }
+    
+    int nbr_threads = omp_get_max_threads();
+    struct rectangle bests[nbr_threads];
+    struct rectangle result = { LONG_MIN, 0, 0, 0, 0 };
+    
+    for (int t = 0; t < nbr_threads; t++) {
+        bests[t] = result;
+    }
+    
+    #pragma omp parallel num_threads(nbr_threads)
+    {
+        long *sums = malloc(columns * sizeof(long));
+        struct rectangle best = result;
+        
+        #pragma omp for schedule(dynamic)
+        for (int top = 0; top < rows; top++) {
+            memset(sums, 0, columns * sizeof(long));
+            for (int bottom = top; bottom < rows; bottom++) {
+                kernels.elements(sums, data + (long) bottom * columns, columns, SCAN_SUM);
+                struct summary summary = summarizeRange(sums, columns, 0);
+                
+                // Candidat exprimé dans les coordonnées de la matrice d'origine
+                struct rectangle candidate = { summary.best, top, (int) summary.bestStart, bottom, (int) summary.bestEnd };
+                if (transposed) {
+                    candidate.top = (int) summary.bestStart;
+                    candidate.left = top;
+                    candidate.bottom = (int) summary.bestEnd;
+                    candidate.right = bottom;
+                }
+                if (rectangleBefore(&candidate, &best))
+                    best = candidate;
+            }
+        }
+        
+        bests[omp_get_thread_num()] = best;
+        free(sums);
+    }
+    
+    for (int t = 0; t < nbr_threads; t++) {
+        if (rectangleBefore(&bests[t], &result))
+            result = bests[t];
+    }
+    
+    if (transposed)
+        free(data);
+    
+    return result;
+}
+
+/**
+ * Cherche la valeur maximale de M, son premier indice et la fin de la suite d'indices où M garde cette valeur
+ * (findSegmentInt64())
+ * @param *M valeurs de M
+ * @param size nombre de valeurs
+ * @param *max valeur maximale (LONG_MIN si M est vide)
+ * @param *start premier indice de la valeur maximale
+ * @param *end fin (exclue) de la suite d'indices qui commence à 'start'
+ * @return void
+ */
+void findSegment(long *M, int size, long *max, int *start, int *end) {
+    findSegmentInt64(M, size, max, start, end);
+}
+
+/**
+ * Affiche la somme maximale puis les entiers de la sous-séquence [start, end[
+ * @param max somme maximale
+ * @param *values entiers du tablo de référence
+ * @param start début de la sous-séquence
+ * @param end fin (exclue) de la sous-séquence
+ * @return void
+ */
+void printSegment(long max, long *values, int start, int end) {
+    struct writer writer;
+    openWriter(&writer, stdout);
+    
+    // On affiche le max en premier
+    writeLong(&writer, 0, max);
+    // Tant que cette valeur est présente dans M, on écrit l'entier correspondant du tablo 'source'
+    for (int index = start; index < end; index++) {
+        writeLong(&writer, ' ', values[index]);
+    }
+    closeWriter(&writer);
+}
+
+/**
+ * Affiche la somme maximale d'une sous-séquence et la sous-séquence correspondante
+ * @param *M tablo maximal
+ * @param *source tablo de référence
+ * @return void
+ */
+void displayResult(struct tablo *M, struct tablo *source) {
+    long max;
+    int start;
+    int end;
+    
+    findSegment(M->tab, M->size, &max, &start, &end);
+    printSegment(max, source->tab, start, end);
+}
+
+/**
+ * Version séquentielle de référence (--kadane) : algorithme de Kadane en un passage, sans tablo intermédiaire.
+ * Donne les mêmes bornes que findSegment() sur M : le début est celui de la meilleure sous-séquence la plus à gauche,
+ * la fin est la dernière fin d'une meilleure sous-séquence qui commence à ce début (si le max est positif ou nul),
+ * ou la fin de la suite d'entiers égaux au max (si tous les entiers sont négatifs)
+ * @param *source tablo de référence
+ * @param *max somme maximale
+ * @param *start début de la sous-séquence
+ * @param *end fin (exclue) de la sous-séquence
+ * @return void
+ */
+void kadaneSegment(struct tablo *source, long *max, int *start, int *end) {
+    struct summary summary = summarizeRange(source->tab, source->size, 0);
+    
+    *max = (source->size > 0) ? summary.best : LONG_MIN;
+    *start = (source->size > 0) ? (int) summary.bestStart : 0;
+    *end = *start;
+    
+    if (*max < 0) {
+        while (*end < source->size && source->tab[*end] == *max)
+            (*end)++;
+        return;
+    }
+    
+    long sum = 0;
+    for (int i = *start; i < source->size; i++) {
+        sum += source->tab[i];
+        if (sum == *max)
+            *end = i + 1;
+    }
+}
+
+/**
+ * Options de la ligne de commande
+ */
+struct options {
+    char *path; // Fichier d'entrée
+    int tree; // --tree : balayages avec l'arbre de réduction du cours au lieu du balayage par blocs
+    int timing; // --time : affichage du temps de chaque étape sur la sortie d'erreur
+    int fused; // --fused : calcul direct de M sans les tablos intermédiaires (fusedMaximum())
+    int stream; // --stream : lecture du fichier par blocs sans le charger en mémoire (streamMaximum())
+    int block; // --block <n> : nombre d'entiers par bloc du mode --stream
+    char *simd; // --simd <nom> : jeu de noyaux imposé (scalar, sse4.2, avx2, avx512)
+    char *convert; // --convert <sortie> : conversion du fichier d'entrée au format binaire
+    char *queries; // --queries <fichier> : meilleure sous-séquence de chaque intervalle du fichier (queryMaximum())
+    int top; // --top <k> : k meilleures sous-séquences disjointes (topMaximum())
+    int naive; // --naive : version naïve de --top (naiveTopSegments())
+    int matrix; // --2d : sous-matrice de somme maximale (matrixMaximum())
+    int window; // --window <W> : meilleure sous-séquence des W derniers entiers d'un flux (windowMaximum())
+    int every; // --every <B> : nombre de nouveaux entiers entre deux résultats du mode --window
+    char *type; // --type <nom> : type des entiers du balayage par blocs imposé (int32, int64, checked)
+    int batch; // --batch : chaque fichier en paramètre est un tablo (batchMaximum())
+    int lines; // --lines : chaque ligne du fichier d'entrée est un tablo (linesMaximum())
+    int kadane; // --kadane : version séquentielle de référence (kadaneSegment())
+    char **paths; // Fichiers en paramètre, dans l'ordre
+    int nbr_paths;
+};
+
+/**
+ * Lecture des options de la ligne de commande
+ * @param argc nombre d'arguments
+ * @param **argv arguments
+ * @return les options lues
+ */
+struct options parseOptions(int argc, char **argv) {
+    struct options options = { NULL, 0, 0, 0, 0, STREAM_BLOCK, NULL, NULL, NULL, 0, 0, 0, 0, 1, NULL, 0, 0, 0, malloc(argc * sizeof(char *)), 0 };
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tree") == 0)
+            options.tree = 1;
+        else if (strcmp(argv[i], "--time") == 0)
+            options.timing = 1;
+        else if (strcmp(argv[i], "--fused") == 0)
+            options.fused = 1;
+        else if (strcmp(argv[i], "--stream") == 0)
+            options.stream = 1;
+        else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.block = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+            options.simd = argv[++i];
+        else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc)
+            options.convert = argv[++i];
+        else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+            options.queries = argv[++i];
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.top = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--naive") == 0)
+            options.naive = 1;
+        else if (strcmp(argv[i], "--type") == 0 && i + 1 < argc)
+            options.type = argv[++i];
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.window = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--2d") == 0)
+            options.matrix = 1;
+        else if (strcmp(argv[i], "--batch") == 0)
+            options.batch = 1;
+        else if (strcmp(argv[i], "--lines") == 0)
+            options.lines = 1;
+        else if (strcmp(argv[i], "--kadane") == 0)
+            options.kadane = 1;
+        else {
+            options.path = argv[i];
+            options.paths[options.nbr_paths++] = argv[i];
+        }
+    }
+    
+    // Le mode --window lit l'entrée standard si aucun fichier n'est donné
+    if (options.path == NULL && options.window == 0) {
+        printf("Fichier manquant en paramètre\n");
+        exit(1);
+    }
+    
+    return options;
+}
+
+/**
+ * Affiche sur la sortie d'erreur la durée d'une étape si l'option --time est active
+ * @param *options options de la ligne de commande
+ * @param *step nom de l'étape
+ * @param start instant de début de l'étape (omp_get_wtime())
+ * @return l'instant de fin de l'étape
+ */
+double printTime(struct options *options, char *step, double start) {
+    double now = omp_get_wtime();
+    
+    if (options->timing)
+        fprintf(stderr, "%s : %f s\n", step, now - start);
+    
+    return now;
+}
+
+char *typeNames[] = { "int32", "int64", "checked" };
+
+/**
+ * Choisit le type des entiers du balayage par blocs d'après l'étendue des valeurs du tablo. Toutes les valeurs
+ * calculées (PSUM, SSUM, leurs max et les termes intermédiaires de l'étape 5) sont bornées par 5 n max|Q[i]| :
+ * int32 si cette borne tient sur 32 bits, int64 si elle tient sur 64 bits, sinon int64 avec détection du dépassement.
+ * @param *source tablo lu
+ * @param *name type imposé par --type (NULL pour le choix automatique), refusé s'il est plus étroit que la borne
+ * @return TYPE_INT32, TYPE_INT64 ou TYPE_CHECKED
+ */
+int elementType(struct tablo *source, char *name) {
+    int forced = -1;
+    if (name != NULL) {
+        for (int type = TYPE_INT32; type <= TYPE_CHECKED; type++) {
+            if (strcmp(name, typeNames[type]) == 0)
+                forced = type;
+        }
+        if (forced < 0) {
+            printf("Erreur : type %s inconnu (int32, int64, checked)\n", name);
+            exit(1);
+        }
+    }
+    
+    unsigned long largest = 0;
+    #pragma omp parallel for reduction(max:largest)
+    for (int i = 0; i < source->size; i++) {
+        unsigned long magnitude = (source->tab[i] < 0) ? -(unsigned long) source->tab[i] : (unsigned long) source->tab[i];
+        if (magnitude > largest)
+            largest = magnitude;
+    }
+    
+    unsigned long n = (source->size > 0) ? source->size : 1;
+    int type = TYPE_CHECKED;
+    if (largest <= INT32_MAX / 5 / n)
+        type = TYPE_INT32;
+    else if (largest <= LONG_MAX / 5 / n)
+        type = TYPE_INT64;
+    
+    // Un type imposé plus étroit que nécessaire tronquerait les valeurs
+    if (forced >= 0 && forced < type) {
+        printf("Erreur : les valeurs ne tiennent pas dans le type %s (au moins %s)\n", typeNames[forced], typeNames[type]);
+        exit(1);
+    }
+    
+    return (forced >= 0) ? forced : type;
+}
+
+/**
+ * Génère maximum##NAME(Q, arena, options, time) : balayages par blocs, étape 5 et affichage du résultat avec des
+ * entiers de type T. Le tablo lu est copié dans le type T s'il est plus petit qu'un long ; PSUM, SSUM, SMAX, PMAX
+ * et M sont pris dans l'arène. En 32 bits, chaque tablo fait la moitié de la taille (deux fois plus d'entiers par
+ * registre vectoriel et par ligne de cache).
+ */
+#define DEFINE_MAXIMUM(T, NAME, ADD, SUB, FIND) \
+void maximum##NAME(struct tablo *Q, struct arena *arena, struct options *options, double time) { \
+    int size = Q->size; \
+    T *source = (T *) Q->tab; \
+    \
+    if (sizeof(T) != sizeof(long)) { \
+        source = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+        _Pragma("omp parallel for") \
+        for (int i = 0; i < size; i++) { \
+            source[i] = (T) Q->tab[i]; \
+        } \
+        time = printTime(options, "convert", time); \
+    } \
+    \
+    T *PSUM = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+    T *SSUM = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+    T *SMAX = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+    T *PMAX = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+    T *M = arenaAlloc(arena, (size_t) size * sizeof(T)); \
+    \
+    scan##NAME(source, PSUM, size, SCAN_SUM, SCAN_PREFIX); \
+    time = printTime(options, "prefixSum", time); \
+    scan##NAME(source, SSUM, size, SCAN_SUM, SCAN_SUFFIX); \
+    time = printTime(options, "suffixSum", time); \
+    scan##NAME(PSUM, SMAX, size, SCAN_MAX, SCAN_SUFFIX); \
+    time = printTime(options, "suffixMax", time); \
+    scan##NAME(SSUM, PMAX, size, SCAN_MAX, SCAN_PREFIX); \
+    time = printTime(options, "prefixMax", time); \
+    \
+    /* Étape 5 */ \
+    _Pragma("omp parallel for") \
+    for (int i = 0; i < size; i++) { \
+        M[i] = ADD(SUB(ADD(SUB(PMAX[i], SSUM[i]), SMAX[i]), PSUM[i]), source[i]); \
+    } \
+    time = printTime(options, "etape5", time); \
+    \
+    long max; \
+    int start; \
+    int end; \
+    FIND(M, size, &max, &start, &end); \
+    printSegment(max, Q->tab, start, end); \
+    printTime(options, "displayResult", time); \
+}
+
+DEFINE_MAXIMUM(int32_t, Int32, PLAIN_ADD, PLAIN_SUB, findSegmentInt32)
+DEFINE_MAXIMUM(long, Int64, PLAIN_ADD, PLAIN_SUB, findSegmentInt64)
+DEFINE_MAXIMUM(long, Checked, CHECKED_ADD, CHECKED_SUB, findSegmentInt64)
+
+/**
+ * Tampons réutilisés par un thread d'un tablo à l'autre en mode --batch / --lines
+ */
+struct scratch {
+    long *values;
+    long *M;
+    int capacity; // Nombre d'entiers de 'values' et 'M'
+    char *text; // Contenu du fichier texte en cours de lecture
+    size_t textCapacity;
+    char *output; // Résultats écrits par le thread depuis le début du paquet de tablos
+    size_t outputLength;
+    size_t outputCapacity;
+};
+
+/**
+ * Position d'un résultat dans les sorties des threads
+ */
+struct result {
+    int thread;
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * Agrandit si besoin les tablos d'un jeu de tampons
+ * @param *scratch tampons du thread
+ * @param size nombre d'entiers nécessaires
+ * @return void
+ */
+void reserveScratch(struct scratch *scratch, int size) {
+    if (size <= scratch->capacity)
+        return;
+    
+    scratch->capacity = (size > 2 * scratch->capacity) ? size : 2 * scratch->capacity;
+    free(scratch->values);
+    free(scratch->M);
+    scratch->values = malloc(scratch->capacity * sizeof(long));
+    scratch->M = malloc(scratch->capacity * sizeof(long));
 }
 
 /**
- Lecture du fichier inspirée de StackOverflow
- https://stackoverflow.com/questions/11543341/reading-strings-integers-etc-from-files-using-fscanf
+ * Écrit le résultat d'un tablo à la suite de la sortie d'un thread, au format de displayResult()
+ * @param *scratch tampons du thread
+ * @param *values entiers du tablo
+ * @param *M valeurs de M du tablo
+ * @param size nombre d'entiers
+ * @param *result position du résultat dans la sortie
+ * @return void
  */
-struct tablo *parseFileAndFillTablo(FILE *file) {
-    struct tablo *source;
+void appendResult(struct scratch *scratch, long *values, long *M, int size, struct result *result) {
+    long max;
+    int start;
+    int end;
     
-    int size = 0;
-    long nb;
+    findSegment(M, size, &max, &start, &end);
     
-    // Recherche du nombre d'entiers (long) présent dans le fichier pour éviter de faire des realloc
-    while (fscanf(file, "%ld", &nb) != EOF) {
-        size++;
+    // Au plus 20 caractères et un séparateur par entier, puis la fin de ligne
+    size_t needed = scratch->outputLength + 21 * (size_t) (end - start + 1) + 2;
+    if (needed > scratch->outputCapacity) {
+        scratch->outputCapacity = (needed > 2 * scratch->outputCapacity) ? needed : 2 * scratch->outputCapacity;
+        scratch->output = realloc(scratch->output, scratch->outputCapacity);
     }
     
-    source = allocateTablo(size);
-    
-    // Retour au début du fichier
-    rewind(file);
-    
-    // Remplissage du tablo
-    for (int i = 0; fscanf(file, "%ld", &nb) != EOF; i++) {
-        source->tab[i] = nb;
+    char *p = formatLong(scratch->output + scratch->outputLength, max);
+    for (int i = start; i < end; i++) {
+        *p++ = ' ';
+        p = formatLong(p, values[i]);
     }
+    *p++ = '\n';
     
-    return source;
+    result->offset = scratch->outputLength;
+    result->length = p - (scratch->output + scratch->outputLength);
+    scratch->outputLength += result->length;
 }
 
 /**
- Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 20 du .pdf)
+ * Écrit dans l'ordre les résultats d'un paquet de tablos, puis vide les sorties des threads
+ * @param *scratches tampons des threads
+ * @param nbr_threads nombre de threads
+ * @param *results positions des résultats
+ * @param count nombre de résultats
+ * @return void
  */
-void up(struct tablo *source, struct tablo *dest) {
-    // Copie du tablo initial à la fin du nouveau tablo
-    #pragma omp parallel for
-    for (int i = 0; i < source->size; i++) {
-        dest->tab[i + source->size] = source->tab[i];
+void flushResults(struct scratch *scratches, int nbr_threads, struct result *results, int count) {
+    for (int k = 0; k < count; k++) {
+        if (results[k].length > 0)
+            fwrite(scratches[results[k].thread].output + results[k].offset, 1, results[k].length, stdout);
     }
     
-    // Algorithme de montée
-    for (int i = log2(source->size) - 1; i >= 0; i--) {
-        int max = pow(2, i + 1) - 1;
-        #pragma omp parallel for
-        for (int j = pow(2, i); j <= max; j++) {
-            dest->tab[j] = dest->tab[2 * j] + dest->tab[2 * j + 1];
-        }
+    for (int t = 0; t < nbr_threads; t++) {
+        scratches[t].outputLength = 0;
     }
 }
 
 /**
- Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 21 du .pdf)
+ * Lecture séquentielle des entiers d'un texte
+ * @param *text texte à lire
+ * @param length taille du texte
+ * @param *values entiers lus (au moins length / 2 + 1 places)
+ * @return le nombre d'entiers lus
  */
-void down(struct tablo *a, struct tablo *b) {
-    b->tab[1] = 0; // Élément neutre de la somme
+int parseArray(char *text, size_t length, long *values) {
+    char *p = text;
+    char *end = text + length;
+    int count = 0;
     
-    // Algorithme de descente préfixe
-    for (int i = 1; i <= log2(a->size / 2); i++) {
-        int max = pow(2, i + 1) - 1;
-        #pragma omp parallel for
-        for (int j = pow(2, i); j <= max; j++) {
-            if (j % 2 == 0) // Si j est pair
-                b->tab[j] = b->tab[j / 2];
-            else
-                b->tab[j] = b->tab[(j - 1) / 2] + a->tab[j - 1];
+    while (1) {
+        while (p < end && isBlank(*p)) {
+            p++;
         }
+        if (p >= end)
+            break;
+        
+        p = parseLong(p, end, &values[count]);
+        count++;
     }
+    
+    return count;
 }
 
 /**
- Même principe que la méthode down() mais on parcourt le tablo à l'envers en adaptant aussi les indices
+ * Lit un petit fichier (texte ou binaire) dans les tampons d'un thread
+ * @param *path chemin du fichier
+ * @param *scratch tampons du thread (le tablo lu est dans 'values')
+ * @return le nombre d'entiers lus
  */
-void downSuffix(struct tablo *a, struct tablo *b) {
-    b->tab[1] = 0;
+int loadArray(char *path, struct scratch *scratch) {
+    FILE *file = fopen(path, "r");
     
-    // Algorithme de descente suffixe
-    for (int i = 1; i <= log2(a->size / 2); i++) {
-        int min = pow(2, i);
-        #pragma omp parallel for
-        for (int j = pow(2, i + 1) - 1; j >= min; j--) {
-            if (j % 2 == 0) // Si j est pair
-                b->tab[j] = b->tab[j / 2] + a->tab[j + 1];
-            else
-                b->tab[j] = b->tab[(j - 1) / 2];
+    if (file == NULL) {
+        printf("Erreur sur l'ouverture du fichier %s\n", path);
+        exit(1);
+    }
+    
+    int count;
+    
+    if (isBinaryFile(file)) {
+        struct reader reader;
+        openReader(&reader, file);
+        reserveScratch(scratch, (int) reader.count);
+        count = readBlock(&reader, scratch->values, (int) reader.count);
+        closeReader(&reader);
+    } else {
+        size_t length = 0;
+        size_t nbr_read;
+        if (scratch->textCapacity == 0) {
+            scratch->textCapacity = 1 << 16;
+            scratch->text = malloc(scratch->textCapacity);
+        }
+        while ((nbr_read = fread(scratch->text + length, 1, scratch->textCapacity - length, file)) > 0) {
+            length += nbr_read;
+            if (length == scratch->textCapacity) {
+                scratch->textCapacity *= 2;
+                scratch->text = realloc(scratch->text, scratch->textCapacity);
+            }
         }
+        reserveScratch(scratch, (int) (length / 2 + 1));
+        count = parseArray(scratch->text, length, scratch->values);
     }
+    
+    fclose(file);
+    
+    return count;
 }
 
 /**
- Même principe que la méthode up() mais on applique le max au lieu de la somme
+ * Libère les tampons des threads
+ * @param *scratches tampons des threads
+ * @param nbr_threads nombre de threads
+ * @return void
  */
-void upMax(struct tablo *source, struct tablo *dest) {
-    // Copie du tablo initial à la fin du nouveau tablo
-    #pragma omp parallel for
-    for (int i = 0; i < source->size; i++) {
-        dest->tab[i + source->size] = source->tab[i];
-    }
-    
-    // Algorithme de montée
-    for (int i = log2(source->size) - 1; i >= 0; i--) {
-        int max = pow(2, i + 1) - 1;
-        #pragma omp parallel for
-        for (int j = pow(2, i); j <= max; j++) {
-            dest->tab[j] = fmaxl(dest->tab[2 * j], dest->tab[2 * j + 1]);
-        }
+void freeScratches(struct scratch *scratches, int nbr_threads) {
+    for (int t = 0; t < nbr_threads; t++) {
+        free(scratches[t].values);
+        free(scratches[t].M);
+        free(scratches[t].text);
+        free(scratches[t].output);
     }
+    free(scratches);
 }
 
 /**
- Même principe que la méthode down() mais on applique le max au lieu de la somme
+ * Mode --batch : résout chaque fichier en paramètre et écrit une ligne de résultat par fichier, dans l'ordre.
+ * Les petits fichiers sont répartis entre les threads (un tablo par thread, calcul séquentiel avec rangeMaximum()),
+ * les fichiers de plus de BATCH_LARGE octets sont traités l'un après l'autre par toute l'équipe (blockMaximum()).
+ * Les tampons de chaque thread sont réutilisés pour tout le lot.
+ * @param *options options de la ligne de commande
+ * @return void
  */
-void downMax(struct tablo *a, struct tablo *b) {
-    b->tab[1] = LONG_MIN; // Élément neutre du max des entiers long
+void batchMaximum(struct options *options) {
+    int nbr_threads = omp_get_max_threads();
+    struct scratch *scratches = calloc(nbr_threads, sizeof(struct scratch));
+    struct result results[BATCH_CHUNK];
+    char large[BATCH_CHUNK];
     
-    // Algorithme de descente préfixe max
-    for (int i = 1; i <= log2(a->size / 2); i++) {
-        int max = pow(2, i + 1) - 1;
-        #pragma omp parallel for
-        for (int j = pow(2, i); j <= max; j++) {
-            if (j % 2 == 0) // Si j est pair
-                b->tab[j] = b->tab[j / 2];
-            else
-                b->tab[j] = fmaxl(b->tab[(j - 1) / 2], a->tab[j - 1]);
+    for (int first = 0; first < options->nbr_paths; first += BATCH_CHUNK) {
+        int count = (options->nbr_paths - first < BATCH_CHUNK) ? options->nbr_paths - first : BATCH_CHUNK;
+        char **paths = options->paths + first;
+        
+        for (int k = 0; k < count; k++) {
+            struct stat status;
+            large[k] = stat(paths[k], &status) == 0 && status.st_size > BATCH_LARGE;
+        }
+        
+        #pragma omp parallel num_threads(nbr_threads)
+        {
+            struct scratch *scratch = &scratches[omp_get_thread_num()];
+            
+            #pragma omp for schedule(dynamic)
+            for (int k = 0; k < count; k++) {
+                if (large[k])
+                    continue;
+                
+                int size = loadArray(paths[k], scratch);
+                rangeMaximum(scratch->values, size, LONG_MIN, LONG_MIN, scratch->M);
+                
+                results[k].thread = omp_get_thread_num();
+                appendResult(scratch, scratch->values, scratch->M, size, &results[k]);
+            }
         }
+        
+        for (int k = 0; k < count; k++) {
+            if (!large[k])
+                continue;
+            
+            FILE *file = fopen(paths[k], "r");
+            if (file == NULL) {
+                printf("Erreur sur l'ouverture du fichier %s\n", paths[k]);
+                exit(1);
+            }
+            struct tablo *Q = readTablo(file);
+            fclose(file);
+            
+            reserveScratch(&scratches[0], Q->size);
+            blockMaximum(Q->tab, Q->size, LONG_MIN, LONG_MIN, scratches[0].M);
+            
+            results[k].thread = 0;
+            appendResult(&scratches[0], Q->tab, scratches[0].M, Q->size, &results[k]);
+            freeTablo(Q);
+        }
+        
+        flushResults(scratches, nbr_threads, results, count);
     }
+    
+    freeScratches(scratches, nbr_threads);
 }
 
 /**
- Même principe que la méthode downSuffixe() mais on applique le max au lieu de la somme
+ * Mode --lines : chaque ligne non vide du fichier d'entrée est un tablo, une ligne de résultat est écrite par tablo.
+ * Même répartition que batchMaximum() : petites lignes réparties entre les threads, longues lignes traitées par toute
+ * l'équipe (parseText() puis blockMaximum()).
+ * @param *file fichier texte ouvert en lecture
+ * @return le nombre de tablos traités
  */
-void downMaxSuffix(struct tablo *a, struct tablo *b) {
-    b->tab[1] = LONG_MIN; // Élément neutre du max des entiers long
+int linesMaximum(FILE *file) {
+    int nbr_threads = omp_get_max_threads();
+    struct scratch *scratches = calloc(nbr_threads, sizeof(struct scratch));
+    struct result results[BATCH_CHUNK];
+    size_t starts[BATCH_CHUNK];
+    size_t ends[BATCH_CHUNK];
+    size_t length;
+    int mapped;
+    char *text = loadText(file, &length, &mapped);
+    size_t position = 0;
+    int nbr_arrays = 0;
     
-    // Algorithme de descente suffixe max
-    for (int i = 1; i <= log2(a->size / 2); i++) {
-        int min = pow(2, i);
-        #pragma omp parallel for
-        for (int j = pow(2, i + 1) - 1; j >= min; j--) {
-            if (j % 2 == 0) // Si j est pair
-                b->tab[j] = fmaxl(b->tab[j / 2], a->tab[j + 1]);
-            else
-                b->tab[j] = b->tab[(j - 1) / 2];
+    while (position < length) {
+        // Découpage en lignes du paquet suivant (les lignes sans entier sont ignorées)
+        int count = 0;
+        while (count < BATCH_CHUNK && position < length) {
+            char *newline = memchr(text + position, '\n', length - position);
+            size_t end = (newline != NULL) ? (size_t) (newline - text) : length;
+            size_t p = position;
+            while (p < end && isBlank(text[p])) {
+                p++;
+            }
+            if (p < end) {
+                starts[count] = position;
+                ends[count] = end;
+                count++;
+            }
+            position = end + 1;
         }
+        
+        #pragma omp parallel num_threads(nbr_threads)
+        {
+            struct scratch *scratch = &scratches[omp_get_thread_num()];
+            
+            #pragma omp for schedule(dynamic)
+            for (int k = 0; k < count; k++) {
+                if (ends[k] - starts[k] > BATCH_LARGE)
+                    continue;
+                
+                reserveScratch(scratch, (int) ((ends[k] - starts[k]) / 2 + 1));
+                int size = parseArray(text + starts[k], ends[k] - starts[k], scratch->values);
+                rangeMaximum(scratch->values, size, LONG_MIN, LONG_MIN, scratch->M);
+                
+                results[k].thread = omp_get_thread_num();
+                appendResult(scratch, scratch->values, scratch->M, size, &results[k]);
+            }
+        }
+        
+        for (int k = 0; k < count; k++) {
+            if (ends[k] - starts[k] <= BATCH_LARGE)
+                continue;
+            
+            struct tablo *Q = parseText(text, starts[k], ends[k], ends[k]);
+            
+            reserveScratch(&scratches[0], Q->size);
+            blockMaximum(Q->tab, Q->size, LONG_MIN, LONG_MIN, scratches[0].M);
+            
+            results[k].thread = 0;
+            appendResult(&scratches[0], Q->tab, scratches[0].M, Q->size, &results[k]);
+            freeTablo(Q);
+        }
+        
+        flushResults(scratches, nbr_threads, results, count);
+        nbr_arrays += count;
     }
+    
+    if (mapped)
+        munmap(text, length);
+    else
+        free(text);
+    
+    freeScratches(scratches, nbr_threads);
+    
+    return nbr_arrays;
 }
 
 /**
- Mise en application de l'algorithme donné dans le cours "Simulation Prefix" (Page 23 du .pdf)
+ * Affiche une ligne "somme début fin" par sous-séquence
+ * @param *segments résumés dont on affiche la meilleure sous-séquence
+ * @param count nombre de résumés
+ * @return void
  */
-void final(struct tablo *a, struct tablo *b) {
-    int max = pow(2, log2(a->size / 2) + 1);
-    #pragma omp parallel for
-    for (int i = pow(2, log2(a->size / 2)); i < max; i++) {
-        b->tab[i] = b->tab[i] + a->tab[i];
+void displaySegments(struct summary *segments, int count) {
+    if (count == 0)
+        return;
+    
+    struct writer writer;
+    openWriter(&writer, stdout);
+    for (int s = 0; s < count; s++) {
+        writeLong(&writer, (s > 0) ? '\n' : 0, segments[s].best);
+        writeLong(&writer, ' ', segments[s].bestStart);
+        writeLong(&writer, ' ', segments[s].bestEnd);
     }
+    closeWriter(&writer);
 }
 
 /**
- Même principe que la méthode final() mais on applique le max au lieu de la somme
+ * Mode --queries : construit l'index de requêtes du tablo, puis écrit pour chaque intervalle [gauche, droite] du
+ * fichier de requêtes (deux entiers par requête, indices à partir de 0) une ligne "somme début fin"
+ * @param *source tablo lu
+ * @param *options options de la ligne de commande
+ * @return void
  */
-void finalMax(struct tablo *a, struct tablo *b) {
-    int max = pow(2, log2(a->size / 2) + 1);
-    #pragma omp parallel for
-    for (int i = pow(2, log2(a->size / 2)); i < max; i++) {
-        b->tab[i] = fmaxl(b->tab[i], a->tab[i]);
+void queryMaximum(struct tablo *source, struct options *options) {
+    double time = omp_get_wtime();
+    struct queryIndex *index = buildQueryIndex(source);
+    time = printTime(options, "buildQueryIndex", time);
+    
+    FILE *file = fopen(options->queries, "r");
+    
+    if (file == NULL) {
+        printf("Erreur sur l'ouverture du fichier de requêtes\n");
+        exit(1);
+    }
+    
+    struct tablo *queries = readTablo(file);
+    fclose(file);
+    
+    if (queries->size % 2 != 0) {
+        printf("Erreur : nombre impair de bornes dans le fichier de requêtes\n");
+        exit(1);
     }
+    
+    int nbr_queries = queries->size / 2;
+    struct summary *answers = malloc(nbr_queries * sizeof(struct summary));
+    time = printTime(options, "parseQueries", time);
+    
+    answerQueries(index, queries->tab, nbr_queries, answers);
+    double end = printTime(options, "answerQueries", time);
+    if (options->timing)
+        fprintf(stderr, "throughput : %f queries/s\n", nbr_queries / (end - time));
+    
+    displaySegments(answers, nbr_queries);
+    printTime(options, "displayAnswers", end);
+    
+    free(answers);
+    freeTablo(queries);
+    freeQueryIndex(index);
 }
 
 /**
- * Calcule la somme préfixe d'un tablo
- * @param *source tablo de référence pour le calcul
- * @param *dest tablo résultat
+ * Mode --top : écrit une ligne "somme début fin" pour chacune des k meilleures sous-séquences disjointes
+ * @param *source tablo lu
+ * @param *options options de la ligne de commande
  * @return void
  */
-void prefixSum(struct tablo *source, struct tablo *dest) {
-    struct tablo *a = allocateTablo(source->size * 2);
+void topMaximum(struct tablo *source, struct options *options) {
+    double time = omp_get_wtime();
+    struct summary *segments = malloc(options->top * sizeof(struct summary));
+    int found;
     
-    up(source, a);
+    if (options->naive) {
+        found = naiveTopSegments(source, options->top, segments);
+        time = printTime(options, "naiveTopSegments", time);
+    } else {
+        found = topSegments(source, options->top, segments);
+        time = printTime(options, "topSegments", time);
+    }
     
-    struct tablo *b = allocateTablo(source->size * 2);
+    displaySegments(segments, found);
+    printTime(options, "displaySegments", time);
     
-    down(a, b);
-    final(a, b);
+    free(segments);
+}
+
+/**
+ * Nombre d'entiers de la première ligne d'un fichier texte (la position dans le fichier est remise au début)
+ * @param *file fichier texte ouvert en lecture
+ * @return le nombre d'entiers de la première ligne
+ */
+int matrixColumns(FILE *file) {
+    int columns = 0;
+    int blank = 1;
     
-    // Copie du résultat dans le tablo 'dest'
-    #pragma omp parallel for
-    for (int i = 0; i < dest->size; i++) {
-        dest->tab[i] = b->tab[i + source->size];
+    for (int c = fgetc(file); c != EOF && c != '\n'; c = fgetc(file)) {
+        if (blank && !isBlank(c))
+            columns++;
+        blank = isBlank(c);
     }
     
-    freeTablo(a);
-    freeTablo(b);
+    rewind(file);
+    
+    return columns;
 }
 
 /**
- * Calcule la somme suffixe d'un tablo
- * @param *source tablo de référence pour le calcul
- * @param *dest tablo résultat
+ * Mode --2d : lit une matrice au format des entrées du Projet2 (une ligne de texte par ligne de la matrice, entiers
+ * séparés par des espaces) et écrit "somme ligne_début colonne_début ligne_fin colonne_fin" de la meilleure
+ * sous-matrice (indices à partir de 0, fins incluses)
+ * @param *file fichier texte ouvert en lecture
+ * @param *options options de la ligne de commande
  * @return void
  */
-void suffixSum(struct tablo *source, struct tablo *dest) {
-    struct tablo *a = allocateTablo(source->size * 2);
-    
-    up(source, a);
+void matrixMaximum(FILE *file, struct options *options) {
+    double time = omp_get_wtime();
     
-    struct tablo *b = allocateTablo(source->size * 2);
+    if (isBinaryFile(file)) {
+        printf("Erreur : le mode --2d attend une matrice au format texte\n");
+        exit(1);
+    }
     
-    downSuffix(a, b);
-    final(a, b);
+    int columns = matrixColumns(file);
+    struct tablo *matrix = readTablo(file);
     
-    // Copie du résultat dans le tablo 'dest'
-    #pragma omp parallel for
-    for (int i = 0; i < dest->size; i++) {
-        dest->tab[i] = b->tab[i + source->size];
+    if (columns == 0 || matrix->size % columns != 0) {
+        printf("Erreur : la matrice n'est pas rectangulaire\n");
+        exit(1);
     }
     
-    freeTablo(a);
-    freeTablo(b);
+    int rows = matrix->size / columns;
+    time = printTime(options, "parse", time);
+    
+    struct rectangle best = maximumSubmatrix(matrix->tab, rows, columns);
+    time = printTime(options, "maximumSubmatrix", time);
+    
+    printf("%ld %d %d %d %d\n", best.sum, best.top, best.left, best.bottom, best.right);
+    
+    freeTablo(matrix);
+}
+
+int compareDouble(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    
+    return (x > y) - (x < y);
 }
 
 /**
- * Calcule le max suffixe d'un tablo
- * @param *source tablo de référence pour le calcul
- * @param *dest tablo résultat
+ * Mode --window : lit un flux d'entiers (fichier, tube ou entrée standard) et écrit, tous les B nouveaux entiers,
+ * une ligne "somme début fin" pour la meilleure sous-séquence des W derniers entiers (indices dans le flux).
+ * Chaque bloc de B entiers est résumé une fois et ajouté à une file de résumés (struct windowQueue) ; les blocs sortis
+ * de la fenêtre sont retirés de la file, et le début de la fenêtre dans le plus ancien bloc est résumé à partir d'un
+ * tampon circulaire des W + B derniers entiers. Une mise à jour coûte O(B) au lieu de O(W).
+ * @param *file flux d'entiers ouvert en lecture
+ * @param *options options de la ligne de commande
  * @return void
  */
-void suffixMax(struct tablo *source, struct tablo *dest) {
-    struct tablo *a = allocateTablo(source->size * 2);
+void windowMaximum(FILE *file, struct options *options) {
+    long capacity = (long) options->window + options->every;
+    long *ring = malloc(capacity * sizeof(long));
+    long *block = malloc(options->every * sizeof(long));
+    struct windowQueue queue;
+    long total = 0; // Nombre d'entiers lus
+    long queueStart = 0; // Indice du premier entier du plus ancien bloc de la file
+    int nbr_updates = 0;
+    int latencyCapacity = 1024;
+    double *latencies = malloc(latencyCapacity * sizeof(double));
+    double start = omp_get_wtime();
+    int eof = 0;
     
-    upMax(source, a);
+    openWindowQueue(&queue, options->window / options->every + 2);
     
-    struct tablo *b = allocateTablo(source->size * 2);
+    while (!eof) {
+        int count = 0;
+        while (count < options->every && readValue(file, &block[count])) {
+            count++;
+        }
+        eof = count < options->every;
+        // En fin de flux, un dernier bloc incomplet donne une dernière mise à jour
+        if (count == 0)
+            break;
+        
+        double time = omp_get_wtime();
+        
+        for (int i = 0; i < count; i++) {
+            ring[(total + i) % capacity] = block[i];
+        }
+        pushBlock(&queue, summarizeRange(block, count, total));
+        total += count;
+        
+        // Les blocs qui commencent avant la fenêtre sont retirés ; leur partie encore dans la fenêtre est résumée à part
+        long windowStart = (total > options->window) ? total - options->window : 0;
+        while (queueStart < windowStart) {
+            queueStart += popBlock(&queue).size;
+        }
+        struct summary window = mergeSummaries(summarizeRing(ring, capacity, windowStart, queueStart - windowStart), queueSummary(&queue));
+        
+        printf("%ld %ld %ld\n", window.best, window.bestStart, window.bestEnd);
+        fflush(stdout);
+        
+        if (nbr_updates == latencyCapacity) {
+            latencyCapacity *= 2;
+            latencies = realloc(latencies, latencyCapacity * sizeof(double));
+        }
+        latencies[nbr_updates++] = omp_get_wtime() - time;
+    }
     
-    downMaxSuffix(a, b);
-    finalMax(a, b);
+    printTime(options, "windowMaximum", start);
+    if (options->timing && nbr_updates > 0) {
+        // Percentiles des durées de mise à jour (résumé du bloc, fenêtre et écriture du résultat)
+        qsort(latencies, nbr_updates, sizeof(double), compareDouble);
+        fprintf(stderr, "updates : %d\n", nbr_updates);
+        fprintf(stderr, "latency_p50 : %f s\n", latencies[nbr_updates / 2]);
+        fprintf(stderr, "latency_p90 : %f s\n", latencies[(long) nbr_updates * 90 / 100]);
+        fprintf(stderr, "latency_p99 : %f s\n", latencies[(long) nbr_updates * 99 / 100]);
+        fprintf(stderr, "latency_max : %f s\n", latencies[nbr_updates - 1]);
+    }
     
-    // Copie du résultat dans le tablo 'dest'
-    #pragma omp parallel for
-    for (int i = 0; i < dest->size; i++) {
-        dest->tab[i] = b->tab[i + source->size];
+    closeWindowQueue(&queue);
+    free(latencies);
+    free(block);
+    free(ring);
+}
+
+#ifdef USE_MPI
+
+/**
+ * Opération MPI de fusion des résumés (non commutative : 'in' vient des rangs inférieurs)
+ */
+void mergeSummariesOp(void *in, void *inout, int *len, MPI_Datatype *type) {
+    struct summary *left = in;
+    struct summary *right = inout;
+    
+    for (int i = 0; i < *len; i++) {
+        right[i] = mergeSummaries(left[i], right[i]);
     }
+}
+
+/**
+ * Même opération pour un communicateur dont les rangs sont inversés ('in' vient des rangs supérieurs du tablo)
+ */
+void mergeSummariesReverseOp(void *in, void *inout, int *len, MPI_Datatype *type) {
+    struct summary *right = in;
+    struct summary *left = inout;
     
-    freeTablo(a);
-    freeTablo(b);
+    for (int i = 0; i < *len; i++) {
+        left[i] = mergeSummaries(left[i], right[i]);
+    }
 }
 
 /**
- * Calcule le max préfixe d'un tablo
- * @param *source tablo de référence pour le calcul
- * @param *dest tablo résultat
- * @return void
+ * Lecture par chaque processus de sa tranche du fichier avec MPI-IO.
+ * Binaire : tranche de count / nbr_procs entiers. Texte : tranche de taille / nbr_procs octets, les entiers
+ * appartenant au processus qui contient leur premier caractère (comme les threads de parseText()).
+ * @param *path chemin du fichier
+ * @param rank rang du processus
+ * @param nbr_procs nombre de processus
+ * @return la tranche du tablo lue par le processus
  */
-void prefixMax(struct tablo *source, struct tablo *dest) {
-    struct tablo *a = allocateTablo(source->size * 2);
+struct tablo *readSlice(char *path, int rank, int nbr_procs) {
+    MPI_File file;
+    MPI_Offset size;
+    struct binaryHeader header;
     
-    upMax(source, a);
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        printf("Erreur sur l'ouverture du fichier\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_File_get_size(file, &size);
     
-    struct tablo *b = allocateTablo(source->size * 2);
+    memset(&header, 0, sizeof(header));
+    if (size >= (MPI_Offset) sizeof(header))
+        MPI_File_read_at(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
     
-    downMax(a, b);
-    finalMax(a, b);
+    struct tablo *slice;
     
-    // Copie du résultat dans le tablo 'dest'
-    #pragma omp parallel for
-    for (int i = 0; i < dest->size; i++) {
-        dest->tab[i] = b->tab[i + source->size];
+    if (memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) == 0) {
+        uint64_t count;
+        uint32_t width;
+        int swap = decodeBinaryHeader(&header, &count, &width);
+        long start = count * rank / nbr_procs;
+        long end = count * (rank + 1) / nbr_procs;
+        char *data = malloc((end - start) * width + 1);
+        
+        MPI_File_read_at_all(file, sizeof(header) + start * width, data, (end - start) * width, MPI_BYTE, MPI_STATUS_IGNORE);
+        
+        slice = allocateTablo(end - start);
+        #pragma omp parallel for
+        for (int i = 0; i < slice->size; i++) {
+            slice->tab[i] = decodeBinaryValue(data, i, width, swap);
+        }
+        free(data);
+    } else {
+        // On lit aussi l'octet qui précède la tranche et de quoi terminer le dernier entier
+        MPI_Offset start = size * rank / nbr_procs;
+        MPI_Offset end = size * (rank + 1) / nbr_procs;
+        MPI_Offset first = (start > 0) ? start - 1 : 0;
+        MPI_Offset last = (end + SLICE_OVERLAP < size) ? end + SLICE_OVERLAP : size;
+        char *text = malloc(last - first + 1);
+        
+        MPI_File_read_at_all(file, first, text, last - first, MPI_BYTE, MPI_STATUS_IGNORE);
+        
+        slice = parseText(text, start - first, end - first, last - first);
+        free(text);
     }
     
-    freeTablo(a);
-    freeTablo(b);
+    MPI_File_close(&file);
+    
+    return slice;
 }
 
 /**
- * Affiche la somme maximale d'une sous-séquence et la sous-séquence correspondante
- * @param *M tablo maximal
- * @param *source tablo de référence
+ * Version MPI : chaque processus lit sa tranche du fichier et la résume avec les noyaux OpenMP (summarize()).
+ * Les résumés sont fusionnés par une réduction en arbre avec une opération MPI dédiée, ce qui donne la somme maximale ;
+ * les retenues de chaque tranche (MPI_Exscan dans les deux sens) permettent ensuite de calculer M localement (blockMaximum()).
+ * P0 rassemble la sous-séquence et affiche le même résultat que displayResult(), ainsi que ses bornes avec --time.
+ * @param *options options de la ligne de commande
  * @return void
  */
-void displayResult(struct tablo *M, struct tablo *source) {
-    long max = LONG_MIN;
-    int index = 0;
+void distributedMaximum(struct options *options) {
+    int rank;
+    int nbr_procs;
     
-    // On cherche la valeur maximale et son index
-    for (int i = 0; i < source->size; i++) {
-        if (max < M->tab[i]) {
-            max = M->tab[i];
-            index = i;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nbr_procs);
+    
+    double time = omp_get_wtime();
+    double start = time;
+    
+    struct tablo *Q = readSlice(options->path, rank, nbr_procs);
+    
+    if (rank == 0)
+        time = printTime(options, "readSlice", time);
+    
+    // Indice du premier entier de la tranche dans le tablo complet
+    long size = Q->size;
+    long offset = 0;
+    MPI_Exscan(&size, &offset, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0)
+        offset = 0;
+    
+    struct summary local = summarize(Q->tab, Q->size, offset);
+    struct summary empty = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    struct summary global;
+    struct summary left = empty;
+    struct summary right = empty;
+    
+    MPI_Datatype summaryType;
+    MPI_Op mergeOp;
+    MPI_Op mergeReverseOp;
+    MPI_Comm reversed;
+    
+    MPI_Type_contiguous(sizeof(struct summary) / sizeof(long), MPI_LONG, &summaryType);
+    MPI_Type_commit(&summaryType);
+    MPI_Op_create(mergeSummariesOp, 0, &mergeOp);
+    MPI_Op_create(mergeSummariesReverseOp, 0, &mergeReverseOp);
+    MPI_Comm_split(MPI_COMM_WORLD, 0, nbr_procs - rank, &reversed);
+    
+    MPI_Allreduce(&local, &global, 1, summaryType, mergeOp, MPI_COMM_WORLD);
+    MPI_Exscan(&local, &left, 1, summaryType, mergeOp, MPI_COMM_WORLD);
+    MPI_Exscan(&local, &right, 1, summaryType, mergeReverseOp, reversed);
+    if (rank == 0)
+        left = empty;
+    if (rank == nbr_procs - 1)
+        right = empty;
+    
+    if (rank == 0)
+        time = printTime(options, "reduction", time);
+    
+    // M sur la tranche, puis partie de la sous-séquence affichée qui s'y trouve
+    long max = (global.size > 0) ? global.best : LONG_MIN;
+    struct tablo *M = allocateTablo(Q->size);
+    blockMaximum(Q->tab, Q->size, (left.size > 0) ? left.suffix : LONG_MIN, (right.size > 0) ? right.prefix : LONG_MIN, M->tab);
+    
+    int first = (global.bestStart > offset) ? ((global.bestStart - offset < Q->size) ? global.bestStart - offset : Q->size) : 0;
+    int length = 0;
+    if (global.size > 0 && global.bestStart < offset + Q->size) {
+        while (first + length < Q->size && M->tab[first + length] == max) {
+            length++;
         }
     }
+    int complete = first + length >= Q->size; // Vrai aussi pour les tranches qui précèdent la sous-séquence
+    int piece[2] = { length, complete };
+    int *pieces = NULL;
+    int *displacements = NULL;
+    int *lengths = NULL;
+    long *values = NULL;
     
-    // On affiche le max en premier
-    printf("%ld", max);
-    // Tant que cette valeur est présente dans M, on écrit l'entier correspondant du tablo 'source'
-    while (index < M->size) {
-        if (!(M->tab[index] == max)) {
-            break;
+    if (rank == 0) {
+        pieces = malloc(2 * nbr_procs * sizeof(int));
+        lengths = malloc(nbr_procs * sizeof(int));
+        displacements = malloc(nbr_procs * sizeof(int));
+    }
+    MPI_Gather(piece, 2, MPI_INT, pieces, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        int total = 0;
+        for (int r = 0; r < nbr_procs; r++) {
+            lengths[r] = pieces[2 * r];
+            displacements[r] = total;
+            total += lengths[r];
         }
-        else {
-            printf(" %ld", source->tab[index]);
-            index++;
+        values = malloc((total + 1) * sizeof(long));
+    }
+    MPI_Gatherv(Q->tab + first, length, MPI_LONG, values, lengths, displacements, MPI_LONG, 0, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        // La sous-séquence continue sur le processus suivant tant que la tranche courante est entièrement couverte
+        long end = global.bestStart;
+        struct writer writer;
+        openWriter(&writer, stdout);
+        writeLong(&writer, 0, max);
+        for (int r = 0; r < nbr_procs; r++) {
+            for (int i = 0; i < lengths[r]; i++) {
+                writeLong(&writer, ' ', values[displacements[r] + i]);
+            }
+            end += lengths[r];
+            if (!pieces[2 * r + 1])
+                break;
         }
+        closeWriter(&writer);
+        
+        time = printTime(options, "gather", time);
+        printTime(options, "distributedMaximum", start);
+        if (options->timing && global.size > 0)
+            fprintf(stderr, "segment : %ld %ld\n", global.bestStart, end - 1);
+        
+        free(pieces);
+        free(lengths);
+        free(displacements);
+        free(values);
     }
-    printf("\n");
+    
+    MPI_Op_free(&mergeOp);
+    MPI_Op_free(&mergeReverseOp);
+    MPI_Type_free(&summaryType);
+    MPI_Comm_free(&reversed);
+    freeTablo(Q);
+    freeTablo(M);
 }
 
+#endif
+
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("Fichier manquant en paramètre\n");
+    struct options options = parseOptions(argc, argv);
+    
+    selectKernels(options.simd);
+    
+#ifdef USE_MPI
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    
+    distributedMaximum(&options);
+    
+    MPI_Finalize();
+    
+    return 0;
+#endif
+    
+    if (options.timing)
+        fprintf(stderr, "kernels : %s\n", kernels.name);
+    
+    if (options.window > 0) {
+        FILE *input = stdin;
+        if (options.path != NULL && strcmp(options.path, "-") != 0)
+            input = fopen(options.path, "r");
+        if (input == NULL) {
+            printf("Erreur sur l'ouverture du fichier\n");
+            exit(1);
+        }
+        
+        windowMaximum(input, &options);
+        if (input != stdin)
+            fclose(input);
+        
+        return 0;
+    }
+    
+    if (options.batch) {
+        double time = omp_get_wtime();
+        batchMaximum(&options);
+        double end = printTime(&options, "batchMaximum", time);
+        if (options.timing)
+            fprintf(stderr, "throughput : %f arrays/s\n", options.nbr_paths / (end - time));
+        
+        return 0;
+    }
+    
+    FILE *file = fopen(options.path, "r");
+    
+    if (file == NULL) {
+        printf("Erreur sur l'ouverture du fichier\n");
         exit(1);
     }
     
-    FILE *file = fopen(argv[1], "r");
+    double time = omp_get_wtime();
     
-    struct tablo *Q = parseFileAndFillTablo(file);
+    if (options.matrix) {
+        matrixMaximum(file, &options);
+        fclose(file);
+        
+        return 0;
+    }
+    
+    if (options.lines) {
+        int nbr_arrays = linesMaximum(file);
+        fclose(file);
+        double end = printTime(&options, "linesMaximum", time);
+        if (options.timing)
+            fprintf(stderr, "throughput : %f arrays/s\n", nbr_arrays / (end - time));
+        
+        return 0;
+    }
+    
+    if (options.stream) {
+        streamMaximum(file, options.block);
+        fclose(file);
+        printTime(&options, "streamMaximum", time);
+        
+        return 0;
+    }
+    
+    struct tablo *Q = readTablo(file);
     
     fclose(file);
     
-    struct tablo *PSUM = allocateTablo(Q->size);
-    struct tablo *SSUM = allocateTablo(Q->size);
-    struct tablo *SMAX = allocateTablo(Q->size);
-    struct tablo *PMAX = allocateTablo(Q->size);
+    time = printTime(&options, "parse", time);
+    
+    if (options.convert != NULL) {
+        writeBinaryTablo(Q, options.convert);
+        freeTablo(Q);
+        
+        return 0;
+    }
+    
+    if (options.queries != NULL) {
+        queryMaximum(Q, &options);
+        freeTablo(Q);
+        
+        return 0;
+    }
+    
+    if (options.top > 0) {
+        topMaximum(Q, &options);
+        freeTablo(Q);
+        
+        return 0;
+    }
+    
+    if (options.kadane) {
+        long max;
+        int start;
+        int end;
+        
+        kadaneSegment(Q, &max, &start, &end);
+        time = printTime(&options, "kadane", time);
+        
+        printSegment(max, Q->tab, start, end);
+        printTime(&options, "displayResult", time);
+        
+        freeTablo(Q);
+        
+        return 0;
+    }
+    
+    // Une seule arène pour M et les tablos de calcul : PSUM, SSUM, SMAX, PMAX et les deux tablos de l'arbre
+    size_t bytes = arenaBytes(Q->size);
+    if (!options.fused)
+        bytes = 5 * arenaBytes(Q->size) + (options.tree ? 2 * arenaBytes(Q->size * 2) : 0);
+    struct arena *arena = createArena(bytes);
+    
+    if (options.fused) {
+        struct tablo *M = arenaTablo(arena, Q->size);
+        
+        fusedMaximum(Q, M);
+        time = printTime(&options, "fusedMaximum", time);
+        
+        displayResult(M, Q);
+        time = printTime(&options, "displayResult", time);
+        
+        freeTablo(Q);
+        freeArena(arena);
+        
+        return 0;
+    }
+    
+    // Balayage par blocs avec le type d'entiers le plus petit possible
+    if (!options.tree) {
+        int type = elementType(Q, options.type);
+        if (options.timing)
+            fprintf(stderr, "type : %s\n", typeNames[type]);
+        time = printTime(&options, "elementType", time);
+        
+        if (type == TYPE_INT32)
+            maximumInt32(Q, arena, &options, time);
+        else if (type == TYPE_INT64)
+            maximumInt64(Q, arena, &options, time);
+        else
+            maximumChecked(Q, arena, &options, time);
+        
+        freeTablo(Q);
+        freeArena(arena);
+        
+        return 0;
+    }
+    
+    struct tablo *PSUM = arenaTablo(arena, Q->size);
+    struct tablo *SSUM = arenaTablo(arena, Q->size);
+    struct tablo *SMAX = arenaTablo(arena, Q->size);
+    struct tablo *PMAX = arenaTablo(arena, Q->size);
     
-    prefixSum(Q, PSUM);
-    suffixSum(Q, SSUM);
-    suffixMax(PSUM, SMAX);
-    prefixMax(SSUM, PMAX);
+    prefixSumTree(Q, PSUM, arena);
+    time = printTime(&options, "prefixSum", time);
+    suffixSumTree(Q, SSUM, arena);
+    time = printTime(&options, "suffixSum", time);
+    suffixMaxTree(PSUM, SMAX, arena);
+    time = printTime(&options, "suffixMax", time);
+    prefixMaxTree(SSUM, PMAX, arena);
+    time = printTime(&options, "prefixMax", time);
     
     /*printTablo(Q);
      printTablo(PSUM);
@@ -364,7 +3630,7 @@ int main(int argc, char **argv) {
      printTablo(SMAX);
      printTablo(PMAX);*/
     
-    struct tablo *M = allocateTablo(Q->size);
+    struct tablo *M = arenaTablo(arena, Q->size);
     
     // Étape 5
     #pragma omp parallel for
@@ -372,16 +3638,16 @@ int main(int argc, char **argv) {
         M->tab[i] = PMAX->tab[i] - SSUM->tab[i] + SMAX->tab[i] - PSUM->tab[i] + Q->tab[i];
     }
     
+    time = printTime(&options, "etape5", time);
+    
     //printTablo(M);
     
     displayResult(M, Q);
     
+    time = printTime(&options, "displayResult", time);
+    
     freeTablo(Q);
-    freeTablo(PSUM);
-    freeTablo(SSUM);
-    freeTablo(SMAX);
-    freeTablo(PMAX);
-    freeTablo(M);
+    freeArena(arena);
     
     return 0;
 }
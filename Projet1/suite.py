@@ -0,0 +1,119 @@
+from array import array
+import hashlib
+import sys
+import random
+import os
+import common
+
+tmpFile="/tmp/suite_input"
+outputFile="/tmp/suite_output"
+dataFolder="suite/" # Fichiers .data (deux colonnes séparées par un espace) à tracer comme TP1/Python/pyplot.py
+csvFile=dataFolder + "suite.csv"
+
+# Tailles 10^3 à 10^maxExponent, toutes les étapes chronométrées par --time, accélération par rapport à --kadane
+maxExponent=8 # 10^9 entiers : 8 Go en binaire, sans compter les tablos de calcul
+textMax=10**7 # Au-delà, l'entrée est écrite au format binaire (la lecture mesurée est alors la projection du fichier)
+chunkSize=10**6 # Entiers générés et écrits à la fois
+runs=3
+steps=["parse", "elementType", "convert", "prefixSum", "suffixSum", "suffixMax", "prefixMax", "etape5", "displayResult"]
+scanSteps=["elementType", "convert", "prefixSum", "suffixSum", "suffixMax", "prefixMax", "etape5"]
+
+def randomValues(count, offset) :
+    return common.randomValues(count)
+
+def negativeValues(count, offset) :
+    return [random.randint(-100, -1) for _ in range(count)]
+
+def positiveValues(count, offset) :
+    return [random.randint(1, 100) for _ in range(count)]
+
+def adversarialValues(count, offset) :
+    # +2^40 / -2^40 en alternance : chaque entier est dans une meilleure sous-séquence (tout le tablo est affiché)
+    # et les sommes ne tiennent pas sur 32 bits
+    return [2**40 if (offset + i) % 2 == 0 else -2**40 for i in range(count)]
+
+generators={"random" : randomValues, "negative" : negativeValues, "positive" : positiveValues, "adversarial" : adversarialValues}
+
+def generate(generator, size) :
+    binary = size > textMax
+    with open(tmpFile, "wb") as f:
+        if binary :
+            f.write(common.binaryHeader(size))
+        for offset in range(0, size, chunkSize) :
+            values=generator(min(chunkSize, size - offset), offset)
+            if binary :
+                f.write(array("q", values).tobytes())
+            else :
+                f.write((" ".join(str(v) for v in values) + " ").encode())
+        if not binary :
+            f.write(b"\n")
+    return "binary" if binary else "text"
+
+def threadCounts() :
+    counts=[1]
+    while counts[-1] * 2 <= os.cpu_count() :
+        counts.append(counts[-1] * 2)
+    if counts[-1] != os.cpu_count() :
+        counts.append(os.cpu_count())
+    return counts
+
+def timeRun(binFile, options, threads, computeSteps) :
+    # Durées de chaque étape affichées par --time (exécution dont la somme des étapes de calcul est la plus petite),
+    # le résultat est écrit dans un fichier : l'empreinte suffit pour comparer les versions
+    env=dict(os.environ, OMP_NUM_THREADS=str(threads))
+
+    def run() :
+        with open(outputFile, "w") as output:
+            timings, stdout = common.timeRun([binFile, "--time"] + options + [tmpFile], stdout=output, env=env)
+        return timings
+
+    def total(timings) :
+        return sum(float(timings.get(step, 0)) for step in computeSteps)
+
+    timings=common.bestRun(runs, run, total)
+    with open(outputFile, "rb") as output:
+        digest=hashlib.md5(output.read()).hexdigest()
+    return total(timings), timings, digest
+
+def writeData(name, rows) :
+    with open(dataFolder + name + ".data", "w") as f:
+        for x, y in rows :
+            f.write(str(x) + " " + str(y) + "\n")
+
+def suite(name, exponent) :
+    binFile=common.compile(name)
+    os.makedirs(dataFolder, exist_ok=True)
+    threads=threadCounts()
+    sizes=[10**e for e in range(3, exponent + 1)]
+
+    header="generator;format;size;threads;type;" + ";".join(steps) + ";scan;kadane;speedup"
+    print(header)
+    with open(csvFile, "w") as csv:
+        csv.write(header + "\n")
+        for generatorName, generator in generators.items() :
+            bySize=[]
+            byThreads=[]
+            for size in sizes :
+                fileFormat=generate(generator, size)
+                kadane, kadaneTimings, kadaneDigest = timeRun(binFile, ["--kadane"], 1, ["kadane"])
+                for t in threads :
+                    scan, timings, digest = timeRun(binFile, [], t, scanSteps)
+                    if digest != kadaneDigest :
+                        print("Résultats différents pour " + generatorName + ", taille " + str(size) + ", " + str(t) + " threads", file=sys.stderr)
+                    line=generatorName + ";" + fileFormat + ";" + str(size) + ";" + str(t) + ";" + timings.get("type", "") + ";" + ";".join(timings.get(step, "0") for step in steps) + ";" + str(scan) + ";" + str(kadane) + ";" + str(kadane / scan)
+                    print(line)
+                    csv.write(line + "\n")
+                    if t == threads[-1] :
+                        bySize.append((size, kadane / scan))
+                    if size == sizes[-1] :
+                        byThreads.append((t, kadane / scan))
+            # Accélération selon la taille (tous les threads) et selon le nombre de threads (plus grande taille)
+            writeData(generatorName + "-sizes", bySize)
+            writeData(generatorName + "-threads", byThreads)
+
+if len(sys.argv) > 2:
+    suite(sys.argv[1], int(sys.argv[2]))
+elif len(sys.argv) > 1:
+    suite(sys.argv[1], maxExponent)
+else :
+    suite("rakotomalala", maxExponent)
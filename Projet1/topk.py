@@ -0,0 +1,36 @@
+import sys
+import common
+
+tmpFile="/tmp/topk_input"
+
+# k meilleures sous-séquences disjointes : tas de candidats (--top) contre copies masquées (--top --naive)
+size=2**22
+ks=[1, 10, 100, 1000]
+naiveMax=100 # La version naïve est en O(k n) : pas de mesure au-delà
+
+def timeRun(binFile, options) :
+    # Durée de la recherche affichée par --time (hors lecture et affichage)
+    timings, output = common.timeRun([binFile, "--time"] + options + [tmpFile])
+    for step in ("topSegments", "naiveTopSegments") :
+        if step in timings :
+            return float(timings[step]), output
+    return None, output
+
+def topk(name) :
+    binFile=common.compile(name)
+    common.writeText(tmpFile, common.randomValues(size))
+    print("k;heap;naive;speedup")
+    for k in ks :
+        heap, heapOutput = timeRun(binFile, ["--top", str(k)])
+        if k > naiveMax :
+            print(str(k) + ";" + str(heap) + ";;")
+            continue
+        naive, naiveOutput = timeRun(binFile, ["--top", str(k), "--naive"])
+        if heapOutput != naiveOutput :
+            print("Résultats différents pour k = " + str(k), file=sys.stderr)
+        print(str(k) + ";" + str(heap) + ";" + str(naive) + ";" + str(naive / heap))
+
+if len(sys.argv) > 1:
+    topk(sys.argv[1])
+else :
+    topk("rakotomalala")
@@ -0,0 +1,39 @@
+import subprocess
+import sys
+import time
+import common
+
+windowFile="/tmp/window_input"
+
+# Fenêtre glissante (--window W --every B) sur un flux lu par un tube, comparée à une exécution complète par fenêtre
+streamSize=2*10**6
+windows=[(10**4, 100), (10**5, 1000), (10**6, 1000)]
+nbrReruns=5
+
+def window(name) :
+    binFile=common.compile(name)
+    values=common.randomValues(streamSize)
+    stream=" ".join(str(v) for v in values) + "\n"
+
+    print("window;every;updates;p50;p90;p99;max;rerun_per_update")
+    for w, b in windows :
+        timings, output = common.timeRun([binFile, "--time", "--window", str(w), "--every", str(b)], input=stream)
+        answers=output.splitlines()
+
+        # Méthode actuelle : le programme complet sur chacune des dernières fenêtres
+        start=time.time()
+        for r in range(nbrReruns) :
+            update=len(answers) - 1 - r
+            end=min((update + 1) * b, streamSize)
+            common.writeText(windowFile, values[max(0, end - w):end])
+            output=subprocess.run([binFile, windowFile], stdout=subprocess.PIPE, universal_newlines=True).stdout
+            if output.split()[0] != answers[update].split()[0] :
+                print("Résultat différent pour la mise à jour " + str(update), file=sys.stderr)
+        rerun=(time.time() - start) / nbrReruns
+
+        print(str(w) + ";" + str(b) + ";" + timings["updates"] + ";" + timings["latency_p50"] + ";" + timings["latency_p90"] + ";" + timings["latency_p99"] + ";" + timings["latency_max"] + ";" + str(rerun))
+
+if len(sys.argv) > 1:
+    window(sys.argv[1])
+else :
+    window("rakotomalala")
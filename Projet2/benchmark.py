@@ -0,0 +1,30 @@
+import subprocess
+import sys
+import common
+
+tmpFile="/tmp/benchmark_graph"
+
+# Durée de chaque étape (--time) et nombre de messages MPI sur des graphes aléatoires : un produit sur l'anneau, et le calcul
+# complet avec Floyd-Warshall par blocs (--blocked)
+sizes=[512, 1024, 2048, 4096]
+procs=[1, 2, 3, 4] # 3 : blocs de tailles différentes
+density=0.1 # Probabilité qu'un arc existe
+products=1 # --products : un seul produit min-plus, le calcul complet est en O(n^4)
+steps=["parse", "transformToW", "scatter", "elevateToN", "gather", "blockedFloyd", "printMatrix"]
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("mode;size;procs;" + ";".join(steps) + ";messages")
+    for size in sizes :
+        common.randomGraph(tmpFile, size, density)
+        for np in procs :
+            timings, output = common.timeRun(binFile, np, ["--dense", "--products", str(products)], tmpFile, stdout=subprocess.DEVNULL)
+            print("ring;" + str(size) + ";" + str(np) + ";" + ";".join(timings.get(step, "") for step in steps) + ";" + timings.get("messages", ""))
+        # Floyd-Warshall par blocs : calcul complet sur P0
+        timings, output = common.timeRun(binFile, 1, ["--blocked"], tmpFile, stdout=subprocess.DEVNULL)
+        print("blocked;" + str(size) + ";1;" + ";".join(timings.get(step, "") for step in steps) + ";" + timings.get("messages", ""))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
@@ -0,0 +1,40 @@
+from subprocess import STDOUT, CalledProcessError
+import subprocess
+import sys
+import random
+
+# Fonctions communes aux scripts de mesure : compilation, génération des graphes et exécution avec --time
+
+binFolder="bin/"
+srcFolder="src/"
+flags=["-std=c99", "-O2"]
+libraries=["-lm", "-fopenmp"]
+
+def compile(f) :
+    name=binFolder + f
+    try:
+        subprocess.check_output(["mpicc"] + flags + ["-o", name, srcFolder + f + ".c"] + libraries, stderr=STDOUT, universal_newlines=True)
+    except  CalledProcessError as e :
+        print(e.output)
+        sys.exit(1)
+    return name
+
+def writeMatrix(path, rows) :
+    with open(path, "w") as f:
+        for row in rows :
+            f.write(" ".join(str(w) for w in row))
+            f.write("\n")
+
+def randomGraph(path, size, density) :
+    # Chaque arc existe avec la probabilité density, poids de 1 à 100 (0 : pas d'arc)
+    writeMatrix(path, ([random.randint(1, 100) if x != y and random.random() < density else 0 for x in range(size)] for y in range(size)))
+
+def timeRun(binFile, np, options, path, stdout=subprocess.PIPE, env=None) :
+    # Durées affichées par P0 avec --time (sortie d'erreur) et matrice calculée (None avec stdout=subprocess.DEVNULL)
+    result = subprocess.run(["mpirun", "--oversubscribe", "-np", str(np), binFile, "--time"] + options + [path], stdout=stdout, stderr=subprocess.PIPE, universal_newlines=True, env=env)
+    timings={}
+    for line in result.stderr.splitlines() :
+        if " : " in line :
+            step, value = line.split(" : ")
+            timings[step]=value.split()[0]
+    return timings, result.stdout
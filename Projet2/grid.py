@@ -0,0 +1,33 @@
+import subprocess
+import sys
+import os
+import common
+
+tmpFile="/tmp/grid_graph"
+
+# Durée d'un produit min-plus et nombre de messages sur l'anneau (elevateToN()) et sur la grille (--grid, gridToN()), à 4, 16
+# et 64 processeurs sur une seule machine. Volume envoyé par processeur et par produit : N^2 cases sur l'anneau,
+# 2 N^2 / √p sur la grille
+size=1024 # Divisible par 64 (anneau) et par 8 (grille)
+procs=[4, 16, 64]
+density=0.1 # Probabilité qu'un arc existe
+products=1
+
+def timeRun(binFile, np, options) :
+    timings, output = common.timeRun(binFile, np, ["--products", str(products)] + options, tmpFile, stdout=subprocess.DEVNULL, env=dict(os.environ, OMP_NUM_THREADS="1"))
+    return timings
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    common.randomGraph(tmpFile, size, density)
+    print("mode;size;procs;scatter;product;gather;messages;volume")
+    for np in procs :
+        ring=timeRun(binFile, np, ["--dense"])
+        print("ring;" + str(size) + ";" + str(np) + ";" + ring.get("scatter", "") + ";" + ring.get("elevateToN", "") + ";" + ring.get("gather", "") + ";" + ring.get("messages", "") + ";" + str(size * size))
+        grid=timeRun(binFile, np, ["--grid"])
+        print("grid;" + str(size) + ";" + str(np) + ";" + grid.get("scatter", "") + ";" + grid.get("gridToN", "") + ";" + grid.get("gather", "") + ";" + grid.get("messages", "") + ";" + str(int(2 * size * size / np ** 0.5)))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
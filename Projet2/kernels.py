@@ -0,0 +1,31 @@
+import subprocess
+import sys
+import common
+
+tmpFile="/tmp/kernels_graph"
+
+# Débit du produit min-plus (--time : "gops", milliards d'additions et de minimums par seconde) de chaque noyau de floyd(),
+# sur un processeur et des graphes aléatoires
+sizes=[512, 1024, 2048]
+kernels=["scalar", "avx2", "avx512"]
+density=0.1 # Probabilité qu'un arc existe
+products=2
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("size;kernel;elevateToN;gops;speedup")
+    for size in sizes :
+        common.randomGraph(tmpFile, size, density)
+        scalar=None
+        for kernel in kernels :
+            timings, output = common.timeRun(binFile, 1, ["--dense", "--kernel", kernel, "--products", str(products)], tmpFile, stdout=subprocess.DEVNULL)
+            if "gops" not in timings :
+                continue # Noyau non supporté par le processeur
+            if scalar is None :
+                scalar=float(timings["gops"])
+            print(str(size) + ";" + kernel + ";" + timings["elevateToN"] + ";" + timings["gops"] + ";" + str(float(timings["gops"]) / scalar))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
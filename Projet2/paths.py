@@ -0,0 +1,32 @@
+import subprocess
+import sys
+import common
+
+tmpFile="/tmp/paths_graph"
+
+# Surcoût de --paths (matrice des successeurs) : durée des élévations au carré et du gather, place occupée par processeur.
+# Les successeurs sont calculés dans la passe du noyau min-plus : chaque noyau est mesuré avec et sans --paths
+sizes=[256, 512, 1024]
+procs=2
+density=0.1 # Probabilité qu'un arc existe
+steps=["squareToN", "gather"]
+kernels=["scalar", "avx2", "avx512"]
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("size;kernel;paths;" + ";".join(steps) + ";overhead;memory distances;memory hops")
+    for size in sizes :
+        common.randomGraph(tmpFile, size, density)
+        for kernel in kernels :
+            distances, output = common.timeRun(binFile, procs, ["--dense", "--squaring", "--kernel", kernel], tmpFile, stdout=subprocess.DEVNULL)
+            if "squareToN" not in distances :
+                continue # Noyau non supporté par le processeur
+            paths, output = common.timeRun(binFile, procs, ["--dense", "--squaring", "--kernel", kernel, "--paths"], tmpFile, stdout=subprocess.DEVNULL)
+            overhead=float(paths["squareToN"]) / float(distances["squareToN"])
+            print(str(size) + ";" + kernel + ";0;" + ";".join(distances.get(step, "") for step in steps) + ";1.0;;")
+            print(str(size) + ";" + kernel + ";1;" + ";".join(paths.get(step, "") for step in steps) + ";" + str(overhead) + ";" + paths.get("memory distances", "") + ";" + paths.get("memory hops", ""))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
@@ -0,0 +1,31 @@
+import sys
+import common
+
+tmpFile="/tmp/sparse_graph"
+
+# Durée du calcul complet avec le moteur creux (--sparse, Dijkstra depuis chaque sommet) et les moteurs denses
+# (--squaring, --blocked) selon la densité des arcs, pour choisir SPARSE_DENSITY
+size=1024
+densities=[0.005, 0.01, 0.03, 0.05, 0.1, 0.2, 0.5]
+procs=1
+engines={"sparse" : (["--sparse"], "dijkstra"), "squaring" : (["--dense", "--squaring"], "squareToN"), "blocked" : (["--blocked"], "blockedFloyd")}
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("size;density;" + ";".join(engines))
+    for density in densities :
+        common.randomGraph(tmpFile, size, density)
+        times=[]
+        outputs=set()
+        for engine, (options, step) in engines.items() :
+            timings, output = common.timeRun(binFile, procs, options, tmpFile)
+            times.append(timings.get(step, ""))
+            outputs.add(output)
+        if len(outputs) != 1 :
+            print("Résultats différents pour la densité " + str(density), file=sys.stderr)
+        print(str(size) + ";" + str(density) + ";" + ";".join(times))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
@@ -0,0 +1,38 @@
+import sys
+import random
+import common
+
+tmpFile="/tmp/squaring_graph"
+
+# Durée du calcul complet avec les n - 1 produits de elevateToN() et avec les élévations au carré de squareToN() (--squaring),
+# sur des graphes de diamètre croissant : chaque sommet i est relié aux sommets i + 1 ... i + k (modulo n). Les plus courts
+# chemins ont au moins n / k arcs, squareToN() s'arrête un produit après que W^(2^p) couvre le plus long d'entre eux
+size=256
+neighbours=[64, 16, 4, 1]
+procs=[1, 2, 4]
+
+def generate(size, k) :
+    rows=[]
+    for y in range(size) :
+        row=[0] * size
+        for d in range(1, k + 1) :
+            row[(y + d) % size]=random.randint(1, 100)
+        rows.append(row)
+    common.writeMatrix(tmpFile, rows)
+
+def benchmark(name) :
+    binFile=common.compile(name)
+    print("size;neighbours;procs;elevateToN;squareToN;products;speedup")
+    for k in neighbours :
+        generate(size, k)
+        for np in procs :
+            linear, linearOutput = common.timeRun(binFile, np, ["--dense"], tmpFile)
+            squaring, squaringOutput = common.timeRun(binFile, np, ["--dense", "--squaring"], tmpFile)
+            if linearOutput != squaringOutput :
+                print("Résultats différents pour k = " + str(k) + ", " + str(np) + " processeurs", file=sys.stderr)
+            print(str(size) + ";" + str(k) + ";" + str(np) + ";" + linear["elevateToN"] + ";" + squaring["squareToN"] + ";" + squaring["products"] + ";" + str(float(linear["elevateToN"]) / float(squaring["squareToN"])))
+
+if len(sys.argv) > 1:
+    benchmark(sys.argv[1])
+else :
+    benchmark("rakotomalala")
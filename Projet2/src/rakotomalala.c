@@ -1,78 +1,165 @@
+#define _POSIX_C_SOURCE 200112L // posix_memalign() avec -std=c99
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h> // memcpy(), strcmp()
+#include <stdint.h> // uint8_t, uint16_t, uint32_t (--paths)
 #include <mpi.h> // MPI
 #include <omp.h> // #pragma
 
+// Noyaux AVX2 / AVX-512 compilés avec l'attribut target de gcc et choisis à l'exécution : le binaire compilé sans -march
+// fonctionne sur toutes les machines x86
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FLOYD_SIMD
+#endif
+
 // Définitions de macros utilisées tout au long du projet
 #define INF 4294967295
 
-#define TAG_SIZES 11
-#define TAG_SCATTER_ROWS 12
-#define TAG_SCATTER_COLUMNS 13
+// Alignement des lignes d'une matrice (ligne de cache) : les lignes sont complétées jusqu'à un multiple de 64 octets
+#define MATRIX_ALIGN 64
+
+// Une ligne dont la taille est un multiple de MATRIX_CONFLICT octets reçoit une ligne de cache de plus : sinon les cases
+// d'une même colonne tombent dans les mêmes ensembles du cache
+#define MATRIX_CONFLICT 1024
+
+// Côté des carreaux de la version Floyd-Warshall par blocs (--blocked) : trois carreaux de 64 x 64 entiers tiennent dans le cache L2
+#define FLOYD_TILE 64
+
+// Adresse de la ligne y d'une matrice (lignes contiguës, séparées de 'stride' entiers)
+#define ROW(matrix, y) ((matrix)->data + (size_t) (y) * (matrix)->stride)
+
+// Noyaux du produit min-plus (option --kernel)
+#define KERNEL_SCALAR 0
+#define KERNEL_AVX2 1
+#define KERNEL_AVX512 2
+
+// En dessous de cette densité d'arcs (arcs / (N (N - 1))), le moteur creux (Dijkstra depuis chaque sommet) est choisi : à
+// 1024 sommets, il est plus rapide que --squaring avec le noyau AVX-512 jusqu'à une densité entre 0,2 et 0,5 (sparse.py)
+#define SPARSE_DENSITY 0.25
+
+// Paquets du tas radix : un par longueur de préfixe commun avec la dernière clé extraite (clés sur 32 bits)
+#define RADIX_BUCKETS 33
+
+// Lignes multipliées entre deux MPI_Testall pendant la circulation des colonnes (voir ringProduct())
+#define RING_CHUNK 32
+
+// Colonnes traitées à la fois par le noyau min-plus : la ligne chargée sert à autant d'accumulateurs gardés dans des registres
+#define FLOYD_COLUMNS 4
+
 #define TAG_CIRCULATE 14
-#define TAG_GATHER 15
-
-// Redéfinition du minimum et de l'addition pour l'algorithme de Floyd-Marshall
-unsigned int min(unsigned int a, unsigned int b) {
-    if (a == INF)
-        return b;
-    else if (b == INF)
-        return a;
-    else
-        return a < b ? a : b;
+#define TAG_SHIFT 16
+
+// Redéfinition du minimum et de l'addition pour l'algorithme de Floyd-Marshall, sans branchement : INF est le plus grand
+// entier non signé, c'est donc l'élément neutre du minimum, et l'addition sature à INF. Si a + b dépasse INF, alors a > ~b
+// et ~b + b = INF ; sinon a + b
+static inline unsigned int min(unsigned int a, unsigned int b) {
+    return a < b ? a : b;
 }
 
-unsigned int sum(unsigned int a, unsigned int b) {
-    if (a == INF || b == INF)
-        return INF;
-    else
-        return a + b;
+static inline unsigned int sum(unsigned int a, unsigned int b) {
+    return min(a, ~b) + b;
 }
 
-// Structure utilisée pour le projet
+// Structure utilisée pour le projet : les lignes sont rangées les unes après les autres dans un seul bloc aligné,
+// un bloc de lignes consécutives s'envoie donc en un seul message MPI
 struct Matrix {
-    unsigned int** data;
+    unsigned int* data;
+    int columns;
+    int rows;
+    int stride; // Nombre d'entiers entre le début de deux lignes consécutives (columns complété, voir allocateMatrix())
+};
+
+// Matrice des successeurs (--paths) : la case (y, z) est le sommet qui suit y sur un plus court chemin de y à z. Les
+// lignes sont contiguës et les cases ont le plus petit type non signé qui contient les indices des N sommets et une valeur
+// "aucun successeur" (voir allocateHops())
+struct Hops {
+    void* data;
+    int width; // Taille d'une case en octets : 1, 2 ou 4
     int columns;
     int rows;
 };
 
+// Graphe creux au format CSR : les arcs sortant du sommet y sont targets[offsets[y]] à targets[offsets[y + 1] - 1]
+struct Graph {
+    int vertices;
+    int edges;
+    int* offsets; // vertices + 1 cases
+    int* targets;
+    unsigned int* weights;
+};
+
+// Nombre de messages MPI envoyés par le processeur (affiché avec --time)
+long nbr_messages = 0;
+
+// Durée des messages de l'anneau recouverte par le calcul et durée d'attente après le calcul (voir ringProduct())
+double comm_hidden = 0;
+double comm_exposed = 0;
+
+// Noyau utilisé par floyd() (KERNEL_SCALAR, KERNEL_AVX2 ou KERNEL_AVX512, voir chooseKernel())
+int kernel = KERNEL_SCALAR;
+
 void printMatrix(struct Matrix *matrix) {
     for (int y = 0; y < matrix->rows; y++) {
         for (int x = 0; x < matrix->columns; x++) {
-            if (matrix->data[y][x] == INF)
+            if (ROW(matrix, y)[x] == INF)
                 printf("i ");
             else
-                printf("%u ", matrix->data[y][x]);
+                printf("%u ", ROW(matrix, y)[x]);
         }
         printf("\n");
     }
 }
 
+/**
+ * Alloue une matrice dont les lignes sont contiguës, alignées sur MATRIX_ALIGN octets et décalées d'une ligne de cache si
+ * leur taille est un multiple de MATRIX_CONFLICT octets
+ * @param columns : le nombre de colonnes
+ * @param rows : le nombre de lignes
+ * @return la matrice, dont les entiers de complément en fin de ligne valent INF
+ */
 struct Matrix* allocateMatrix(int columns, int rows) {
     struct Matrix *tmp = malloc(sizeof(struct Matrix));
+    int per_line = MATRIX_ALIGN / sizeof(unsigned int);
     
     tmp->columns = columns;
     tmp->rows = rows;
-    tmp->data = (unsigned int**) malloc(sizeof(unsigned int*) * rows);
-        
+    tmp->stride = ((columns + per_line - 1) / per_line) * per_line;
+    if ((tmp->stride * sizeof(unsigned int)) % MATRIX_CONFLICT == 0)
+        tmp->stride += per_line;
+    
+    size_t bytes = sizeof(unsigned int) * (size_t) tmp->stride * rows;
+    void *data;
+    if (posix_memalign(&data, MATRIX_ALIGN, bytes > 0 ? bytes : MATRIX_ALIGN) != 0) {
+        printf("Erreur d'allocation de la matrice\n");
+        exit(1);
+    }
+    tmp->data = data;
+    
     #pragma omp parallel for
-    for (int i = 0; i < rows; i++) {
-        tmp->data[i] = (unsigned int*) malloc(sizeof(unsigned int) * columns);
+    for (int y = 0; y < rows; y++) {
+        for (int x = columns; x < tmp->stride; x++)
+            ROW(tmp, y)[x] = INF;
     }
     
     return tmp;
 }
 
 void freeMatrix(struct Matrix *matrix) {
-    #pragma omp parallel for
-    for (int i = 0; i < matrix->rows; i++) {
-        free(matrix->data[i]);
-    }
-    
     free(matrix->data);
     free(matrix);
 }
 
+/**
+ * Nombre d'entiers d'un bloc de lignes, tel qu'envoyé en un message MPI (compléments de fin de ligne compris)
+ * @param matrix : la matrice dont on envoie des lignes
+ * @param rows : le nombre de lignes du bloc
+ * @return le nombre d'entiers du bloc
+ */
+int blockCount(struct Matrix* matrix, int rows) {
+    return rows * matrix->stride;
+}
+
 /**
  * Calcule la transposée de la matrice passée en paramètre
  * @param matrix  : matrice dont on calcule la transposée
@@ -83,15 +170,196 @@ struct Matrix* transpose(struct Matrix* matrix) {
 
     #pragma omp parallel for
     for (int y = 0; y < matrix->rows; y++) {
-        #pragma omp parallel for
         for (int x = 0; x < matrix->columns; x++) {
-            transpose->data[x][y] = matrix->data[y][x];
+            ROW(transpose, x)[y] = ROW(matrix, y)[x];
         }
     }
 
     return transpose;
 }
 
+/**
+ * Noyau scalaire du produit min-plus : ROW(result, y)[startZ + i] = min_x (ROW(W_row, y)[x] + ROW(W_column, i)[x]) pour les
+ * lignes y de yStart à yEnd et chaque colonne i du processeur. Les lignes sont parcourues jusqu'à 'stride' : les cases de complétion valent
+ * INF et ne changent pas le minimum. FLOYD_COLUMNS colonnes par passage sur la ligne : autant de minimums indépendants
+ * @param W_row : la matrice ligne possiblement élevée une puissance quelconque
+ * @param W_column : la matrice colonne (colonnes rangées en lignes)
+ * @param result : la matrice dans laquelle on va stocker les résultats
+ * @param yStart : la première ligne calculée
+ * @param yEnd : la ligne après la dernière ligne calculée
+ * @param nbr_tab : le nombre de colonnes de "W_column"
+ * @param startZ : l'indice de la première colonne de "result" calculée
+ * @return void
+ */
+void floydScalar(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int yStart, int yEnd, int nbr_tab, int startZ) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        int i = 0;
+        for (; i + FLOYD_COLUMNS <= nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1);
+            unsigned int* c2 = ROW(W_column, i + 2);
+            unsigned int* c3 = ROW(W_column, i + 3);
+            unsigned int v0 = INF, v1 = INF, v2 = INF, v3 = INF;
+            for (int x = 0; x < W_row->stride; x++) {
+                unsigned int r = row[x];
+                v0 = min(v0, sum(r, c0[x]));
+                v1 = min(v1, sum(r, c1[x]));
+                v2 = min(v2, sum(r, c2[x]));
+                v3 = min(v3, sum(r, c3[x]));
+            }
+            ROW(result, y)[startZ + i] = v0;
+            ROW(result, y)[startZ + i + 1] = v1;
+            ROW(result, y)[startZ + i + 2] = v2;
+            ROW(result, y)[startZ + i + 3] = v3;
+        }
+        for (; i < nbr_tab; i++) {
+            unsigned int* column = ROW(W_column, i);
+            unsigned int value = INF;
+            for (int x = 0; x < W_row->stride; x++)
+                value = min(value, sum(row[x], column[x]));
+            ROW(result, y)[startZ + i] = value;
+        }
+    }
+}
+
+#ifdef FLOYD_SIMD
+// Addition saturée et minimum sur 8 entiers non signés (voir sum())
+__attribute__((target("avx2")))
+static inline __m256i sum256(__m256i a, __m256i b) {
+    return _mm256_add_epi32(_mm256_min_epu32(a, _mm256_xor_si256(b, _mm256_set1_epi32(-1))), b);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned int reduce256(__m256i a) {
+    __m128i m = _mm_min_epu32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (unsigned int) _mm_cvtsi128_si32(m);
+}
+
+/**
+ * Noyau AVX2 du produit min-plus (voir floydScalar()) : 8 entiers à la fois, FLOYD_COLUMNS colonnes par passage sur la ligne
+ */
+__attribute__((target("avx2")))
+void floydAVX2(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int yStart, int yEnd, int nbr_tab, int startZ) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        int i = 0;
+        for (; i + FLOYD_COLUMNS <= nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1);
+            unsigned int* c2 = ROW(W_column, i + 2);
+            unsigned int* c3 = ROW(W_column, i + 3);
+            __m256i v0 = _mm256_set1_epi32(-1), v1 = v0, v2 = v0, v3 = v0;
+            for (int x = 0; x < W_row->stride; x += 8) {
+                __m256i r = _mm256_load_si256((__m256i*) (row + x));
+                v0 = _mm256_min_epu32(v0, sum256(r, _mm256_load_si256((__m256i*) (c0 + x))));
+                v1 = _mm256_min_epu32(v1, sum256(r, _mm256_load_si256((__m256i*) (c1 + x))));
+                v2 = _mm256_min_epu32(v2, sum256(r, _mm256_load_si256((__m256i*) (c2 + x))));
+                v3 = _mm256_min_epu32(v3, sum256(r, _mm256_load_si256((__m256i*) (c3 + x))));
+            }
+            ROW(result, y)[startZ + i] = reduce256(v0);
+            ROW(result, y)[startZ + i + 1] = reduce256(v1);
+            ROW(result, y)[startZ + i + 2] = reduce256(v2);
+            ROW(result, y)[startZ + i + 3] = reduce256(v3);
+        }
+        for (; i < nbr_tab; i++) {
+            unsigned int* column = ROW(W_column, i);
+            __m256i v = _mm256_set1_epi32(-1);
+            for (int x = 0; x < W_row->stride; x += 8)
+                v = _mm256_min_epu32(v, sum256(_mm256_load_si256((__m256i*) (row + x)), _mm256_load_si256((__m256i*) (column + x))));
+            ROW(result, y)[startZ + i] = reduce256(v);
+        }
+    }
+}
+
+// Addition saturée sur 16 entiers non signés (voir sum())
+__attribute__((target("avx512f")))
+static inline __m512i sum512(__m512i a, __m512i b) {
+    return _mm512_add_epi32(_mm512_min_epu32(a, _mm512_xor_si512(b, _mm512_set1_epi32(-1))), b);
+}
+
+/**
+ * Noyau AVX-512 du produit min-plus (voir floydScalar()) : 16 entiers à la fois (une ligne de cache), FLOYD_COLUMNS colonnes
+ * par passage sur la ligne
+ */
+__attribute__((target("avx512f")))
+void floydAVX512(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int yStart, int yEnd, int nbr_tab, int startZ) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        int i = 0;
+        for (; i + FLOYD_COLUMNS <= nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1);
+            unsigned int* c2 = ROW(W_column, i + 2);
+            unsigned int* c3 = ROW(W_column, i + 3);
+            __m512i v0 = _mm512_set1_epi32(-1), v1 = v0, v2 = v0, v3 = v0;
+            for (int x = 0; x < W_row->stride; x += 16) {
+                __m512i r = _mm512_load_si512(row + x);
+                v0 = _mm512_min_epu32(v0, sum512(r, _mm512_load_si512(c0 + x)));
+                v1 = _mm512_min_epu32(v1, sum512(r, _mm512_load_si512(c1 + x)));
+                v2 = _mm512_min_epu32(v2, sum512(r, _mm512_load_si512(c2 + x)));
+                v3 = _mm512_min_epu32(v3, sum512(r, _mm512_load_si512(c3 + x)));
+            }
+            ROW(result, y)[startZ + i] = _mm512_reduce_min_epu32(v0);
+            ROW(result, y)[startZ + i + 1] = _mm512_reduce_min_epu32(v1);
+            ROW(result, y)[startZ + i + 2] = _mm512_reduce_min_epu32(v2);
+            ROW(result, y)[startZ + i + 3] = _mm512_reduce_min_epu32(v3);
+        }
+        for (; i < nbr_tab; i++) {
+            unsigned int* column = ROW(W_column, i);
+            __m512i v = _mm512_set1_epi32(-1);
+            for (int x = 0; x < W_row->stride; x += 16)
+                v = _mm512_min_epu32(v, sum512(_mm512_load_si512(row + x), _mm512_load_si512(column + x)));
+            ROW(result, y)[startZ + i] = _mm512_reduce_min_epu32(v);
+        }
+    }
+}
+#endif
+
+/**
+ * Choix du noyau de floyd() : celui demandé par --kernel, sinon le plus large supporté par le processeur
+ * @param name : le nom du noyau demandé ("scalar", "avx2", "avx512"), NULL pour le choix automatique
+ * @return le noyau (KERNEL_SCALAR, KERNEL_AVX2 ou KERNEL_AVX512)
+ */
+int chooseKernel(char* name) {
+    int avx2 = 0, avx512 = 0;
+#ifdef FLOYD_SIMD
+    avx2 = __builtin_cpu_supports("avx2");
+    avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    
+    if (name == NULL)
+        return avx512 ? KERNEL_AVX512 : (avx2 ? KERNEL_AVX2 : KERNEL_SCALAR);
+    if (strcmp(name, "scalar") == 0)
+        return KERNEL_SCALAR;
+    if (strcmp(name, "avx2") == 0 && avx2)
+        return KERNEL_AVX2;
+    if (strcmp(name, "avx512") == 0 && avx512)
+        return KERNEL_AVX512;
+    
+    printf("Erreur : noyau %s inconnu ou non supporté par le processeur\n", name);
+    exit(1);
+}
+
+/**
+ * floyd() sur les lignes yStart à yEnd seulement, avec le noyau choisi (voir floydScalar())
+ */
+void floydRows(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int yStart, int yEnd, int nbr_tab, int startZ) {
+#ifdef FLOYD_SIMD
+    if (kernel == KERNEL_AVX512)
+        floydAVX512(W_row, W_column, result, yStart, yEnd, nbr_tab, startZ);
+    else if (kernel == KERNEL_AVX2)
+        floydAVX2(W_row, W_column, result, yStart, yEnd, nbr_tab, startZ);
+    else
+#endif
+        floydScalar(W_row, W_column, result, yStart, yEnd, nbr_tab, startZ);
+}
+
 /**
  * Applique l'algorithme de Floyd-Marshall entre une ligne et une colonne (voire plus) et stocke le résultat au bon indice de la matrice "result"
  * @param W_row : la matrice colonne possiblement élevée une puissance quelconque
@@ -102,18 +370,7 @@ struct Matrix* transpose(struct Matrix* matrix) {
  * @return void
  */
 void floyd(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int nbr_tab, int startZ) {
-    int i = 0;
-    for (int z = startZ; z < (nbr_tab + startZ); z++) {
-        #pragma omp parallel for
-        for (int y = 0; y < nbr_tab; y++) {
-            result->data[y][z] = INF;
-            #pragma omp parallel for
-            for (int x = 0; x < W_row->columns; x++) {
-                result->data[y][z] = min(result->data[y][z], (sum(W_row->data[y][x], W_column->data[i][x])));
-            }
-        }
-        i++;
-    }
+    floydRows(W_row, W_column, result, 0, nbr_tab, nbr_tab, startZ);
 }
 
 /**
@@ -148,7 +405,7 @@ struct Matrix* parseFileAndFillMatrix(char* filePath) {
     fscanf(file, "%u", &nb);
       for (int y = 0; !feof(file); y++){
         for (int x = 0; x < size; x++) {
-            matrix->data[y][x] = nb;
+            ROW(matrix, y)[x] = nb;
             fscanf(file, "%u", &nb);
         }
       }
@@ -158,6 +415,91 @@ struct Matrix* parseFileAndFillMatrix(char* filePath) {
     return matrix;
 }
 
+/**
+ * Ouverture d'un fichier et lecture de celui-ci pour construire le graphe creux (CSR) : un arc y -> x pour chaque valeur
+ * A[y][x] > 0 hors de la diagonale, comme dans transformToW(). Les lignes sont lues dans l'ordre, les tableaux d'arcs
+ * grandissent au besoin
+ * @param filePath : le chemin du fichier à ouvrir et lire
+ * @return le graphe du fichier
+ */
+struct Graph* parseFileToGraph(char* filePath) {
+    FILE* file;
+    
+    if ((file = fopen(filePath, "r")) == NULL) {
+        printf("Erreur sur l'ouverture du fichier\n");
+        exit(1);
+    }
+    
+    int size = 1;
+    char c;
+    unsigned int nb;
+    
+    for (c = fgetc(file); c != '\n'; c = fgetc(file)) {
+        if (c == ' ') {
+            size++;
+        }
+    }
+    
+    // Retour au début du fichier
+    rewind(file);
+    
+    struct Graph* graph = malloc(sizeof(struct Graph));
+    int capacity = size;
+    graph->vertices = size;
+    graph->edges = 0;
+    graph->offsets = malloc(sizeof(int) * (size + 1));
+    graph->targets = malloc(sizeof(int) * capacity);
+    graph->weights = malloc(sizeof(unsigned int) * capacity);
+    
+    for (int y = 0; y < size; y++) {
+        graph->offsets[y] = graph->edges;
+        for (int x = 0; x < size; x++) {
+            if (fscanf(file, "%u", &nb) != 1)
+                nb = 0;
+            if (nb > 0 && x != y) {
+                if (graph->edges == capacity) {
+                    capacity *= 2;
+                    graph->targets = realloc(graph->targets, sizeof(int) * capacity);
+                    graph->weights = realloc(graph->weights, sizeof(unsigned int) * capacity);
+                }
+                graph->targets[graph->edges] = x;
+                graph->weights[graph->edges] = nb;
+                graph->edges++;
+            }
+        }
+    }
+    graph->offsets[size] = graph->edges;
+    
+    fclose(file);
+    
+    return graph;
+}
+
+/**
+ * Construit la matrice A (0 pour l'absence d'arc) du graphe, pour les produits min-plus
+ * @param graph : le graphe
+ * @return la matrice du graphe
+ */
+struct Matrix* graphToMatrix(struct Graph* graph) {
+    struct Matrix* matrix = allocateMatrix(graph->vertices, graph->vertices);
+    
+    #pragma omp parallel for
+    for (int y = 0; y < graph->vertices; y++) {
+        memset(ROW(matrix, y), 0, sizeof(unsigned int) * graph->vertices);
+        for (int e = graph->offsets[y]; e < graph->offsets[y + 1]; e++)
+            ROW(matrix, y)[graph->targets[e]] = graph->weights[e];
+    }
+    
+    return matrix;
+}
+
+void freeGraph(struct Graph* graph) {
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+    free(graph);
+}
+
 /**
  * Construit la matrice adjacente W de celle passée en paramètre
  * @param A : la matrice dont on doit construire sa matrice adjacente
@@ -168,14 +510,13 @@ struct Matrix* transformToW(struct Matrix* A) {
 
     #pragma omp parallel for
     for (int y = 0; y < A->rows; y++) {
-        #pragma omp parallel for
         for (int x = 0; x < A->columns; x++) {
             if (x == y)
-                W->data[x][y] = 0;
-            else if (A->data[x][y] > 0)
-                W->data[x][y] = A->data[x][y];
+                ROW(W, x)[y] = 0;
+            else if (ROW(A, x)[y] > 0)
+                ROW(W, x)[y] = ROW(A, x)[y];
             else
-                W->data[x][y] = INF;
+                ROW(W, x)[y] = INF;
         }
     }
 
@@ -183,119 +524,473 @@ struct Matrix* transformToW(struct Matrix* A) {
 }
 
 /**
- * Permet à un processeur de recevoir de son prédécesseur et d'envoyer à son successeur un entier (si le successeur n'est pas 0)
- * @param value_to_broadcast : le pointeur de la valeur que le souhaite envoyer/récupérer
- * @param rank : le rang du processeur qui appelle la méthode
- * @param previous : le successeur du processeur actuel
- * @param next : le suivant du processeur actuel
+ * Répartition équilibrée des lignes : le processeur r reçoit N / p lignes, plus une si r < N % p (aucune si N < p et r >= N)
+ * @param tab_size : le nombre de sommets N
+ * @param nbr_procs : le nombre de processeurs p
+ * @param counts : le nombre de lignes de chaque processeur
+ * @param displs : l'indice de la première ligne de chaque processeur
  * @return void
  */
-void broadcast(int* value_to_broadcast, int rank, int previous, int next) {
-    MPI_Status status;
+void distribute(int tab_size, int nbr_procs, int* counts, int* displs) {
+    for (int r = 0; r < nbr_procs; r++) {
+        counts[r] = tab_size / nbr_procs + (r < tab_size % nbr_procs);
+        displs[r] = r == 0 ? 0 : displs[r - 1] + counts[r - 1];
+    }
+}
 
-    if (rank != 0)
-        MPI_Recv(value_to_broadcast, 1, MPI_INT, previous, TAG_SIZES, MPI_COMM_WORLD, &status);
-    if (next != 0)
-        MPI_Send(value_to_broadcast, 1, MPI_INT, next, TAG_SIZES, MPI_COMM_WORLD);
+/**
+ * Distribution des blocs de lignes d'une matrice de P0 (MPI_Scatterv) : les lignes d'un bloc sont contiguës, chaque
+ * processeur reçoit son bloc en un seul message
+ * @param matrix : la matrice à distribuer (P0 seulement)
+ * @param block : le bloc du processeur
+ * @param counts : le nombre de lignes de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @return void
+ */
+void scatter(struct Matrix* matrix, struct Matrix* block, int* counts, int* displs, int nbr_procs, int rank) {
+    int* sendcounts = malloc(sizeof(int) * nbr_procs);
+    int* senddispls = malloc(sizeof(int) * nbr_procs);
+    
+    for (int r = 0; r < nbr_procs; r++) {
+        sendcounts[r] = blockCount(block, counts[r]);
+        senddispls[r] = blockCount(block, displs[r]);
+        if (rank == 0 && r != 0 && counts[r] > 0)
+            nbr_messages++;
+    }
+    
+    MPI_Scatterv(rank == 0 ? matrix->data : NULL, sendcounts, senddispls, MPI_UNSIGNED, block->data, sendcounts[rank], MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    
+    free(sendcounts);
+    free(senddispls);
 }
 
 /**
- * Permet à un processeur de recevoir un bout de matrice de son prédécesseur, de récupérer le bout qui l'intéresse et d'envoyer le reste au suivant
- * @param matrix : la matrice dans laquelle on stocke certaines données
- * @param previous : le prédécesseur du processeur actuel
- * @param next : le successeur du processeur actuel
- * @param nbr_tab : le nombre de ligne de la matrice
- * @param tab_size : le nombre d'éléments par ligne
- * @param nbr_procs_used : le nombre de processeurs utilisés rééllement par le programme
+ * Récupération par P0 des blocs de lignes de tous les processeurs (MPI_Gatherv) : le bloc de P0 est déjà en tête de "result"
+ * @param result : les lignes du processeur, et toute la matrice pour P0
+ * @param counts : le nombre de lignes de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
  * @param rank : le rang du processeur qui appelle la méthode
- * @param tag : le tag MPI sur lequel on souhaite envoyer / récupérer les données
  * @return void
  */
-void scatter(struct Matrix* matrix, int previous, int next, int nbr_tab, int tab_size, int nbr_procs_used, int rank, int tag) {
-    if (rank == 0) {
-        for (int i = 1; i < nbr_procs_used; i++) {
-            for (int y = (i * nbr_tab); y < ((i * nbr_tab) + nbr_tab); y++) {
-                MPI_Send(matrix->data[y], tab_size, MPI_INT, next, tag, MPI_COMM_WORLD);
+void gather(struct Matrix* result, int* counts, int* displs, int nbr_procs, int rank) {
+    int* recvcounts = malloc(sizeof(int) * nbr_procs);
+    int* recvdispls = malloc(sizeof(int) * nbr_procs);
+    
+    for (int r = 0; r < nbr_procs; r++) {
+        recvcounts[r] = blockCount(result, counts[r]);
+        recvdispls[r] = blockCount(result, displs[r]);
+    }
+    if (rank != 0 && counts[rank] > 0)
+        nbr_messages++;
+    
+    if (rank == 0)
+        MPI_Gatherv(MPI_IN_PLACE, 0, MPI_UNSIGNED, result->data, recvcounts, recvdispls, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    else
+        MPI_Gatherv(result->data, recvcounts[rank], MPI_UNSIGNED, NULL, NULL, NULL, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    
+    free(recvcounts);
+    free(recvdispls);
+}
+
+/**
+ * Matrice des successeurs de N sommets : cases sur 1 octet jusqu'à 255 sommets, 2 jusqu'à 65535, 4 au-delà (la plus
+ * grande valeur du type signifie "aucun successeur")
+ * @param tab_size : le nombre de sommets N (colonnes)
+ * @param rows : le nombre de lignes
+ * @return la matrice des successeurs
+ */
+struct Hops* allocateHops(int tab_size, int rows) {
+    struct Hops* hops = malloc(sizeof(struct Hops));
+    
+    hops->width = tab_size <= UINT8_MAX ? 1 : (tab_size <= UINT16_MAX ? 2 : 4);
+    hops->columns = tab_size;
+    hops->rows = rows;
+    hops->data = malloc((size_t) hops->width * tab_size * (rows > 0 ? rows : 1));
+    
+    return hops;
+}
+
+void freeHops(struct Hops* hops) {
+    if (hops == NULL)
+        return;
+    free(hops->data);
+    free(hops);
+}
+
+void swapHops(struct Hops* a, struct Hops* b) {
+    if (a == NULL)
+        return;
+    void* data = a->data;
+    a->data = b->data;
+    b->data = data;
+}
+
+/**
+ * Génère les fonctions de la matrice des successeurs pour des cases de type T (NONE : aucun successeur) :
+ * initHops##NAME(W_row, hops, nbr_tab) : successeur z pour chaque arc y -> z de W (et y -> y), NONE sinon.
+ * storeHop##NAME(...) : successeur de y vers z quand le minimum de la case passe par x (through) : celui de y vers x, ou,
+ * si x = y (le chemin de y à z n'est pas raccourci), celui de y vers z. N'importe quel x qui atteint le minimum convient.
+ * printPath##NAME(hops, source, destination) : suit les successeurs de la source à la destination.
+ */
+#define DEFINE_PATHS(T, NAME, NONE) \
+void initHops##NAME(struct Matrix* W_row, struct Hops* hops, int nbr_tab) { \
+    T* data = hops->data; \
+    _Pragma("omp parallel for") \
+    for (int y = 0; y < nbr_tab; y++) { \
+        for (int z = 0; z < hops->columns; z++) \
+            data[(size_t) y * hops->columns + z] = ROW(W_row, y)[z] == INF ? NONE : (T) z; \
+    } \
+} \
+\
+static inline void storeHop##NAME(struct Hops* hops, struct Hops* hopsResult, int y, int z, unsigned int value, int through, int first) { \
+    T* from = hops->data; \
+    T* to = hopsResult->data; \
+    size_t row = (size_t) y * hops->columns; \
+    if (value == INF) \
+        to[row + z] = NONE; \
+    else if (through == first + y) \
+        to[row + z] = from[row + z]; \
+    else \
+        to[row + z] = from[row + through]; \
+} \
+\
+void printPath##NAME(struct Hops* hops, int source, int destination) { \
+    T* data = hops->data; \
+    int vertex = source; \
+    printf("%d", source); \
+    for (int step = 0; vertex != destination && step < hops->columns; step++) { \
+        vertex = data[(size_t) vertex * hops->columns + destination]; \
+        printf(" -> %d", vertex); \
+    } \
+}
+
+DEFINE_PATHS(uint8_t, 8, UINT8_MAX)
+DEFINE_PATHS(uint16_t, 16, UINT16_MAX)
+DEFINE_PATHS(uint32_t, 32, UINT32_MAX)
+
+void initHops(struct Matrix* W_row, struct Hops* hops, int nbr_tab) {
+    if (hops->width == 1)
+        initHops8(W_row, hops, nbr_tab);
+    else if (hops->width == 2)
+        initHops16(W_row, hops, nbr_tab);
+    else
+        initHops32(W_row, hops, nbr_tab);
+}
+
+// Une case par appel (N^2 par produit, contre N^3 additions) : le test de la largeur ne coûte rien
+static inline void storeHop(struct Hops* hops, struct Hops* hopsResult, int y, int z, unsigned int value, int through, int first) {
+    if (hops->width == 1)
+        storeHop8(hops, hopsResult, y, z, value, through, first);
+    else if (hops->width == 2)
+        storeHop16(hops, hopsResult, y, z, value, through, first);
+    else
+        storeHop32(hops, hopsResult, y, z, value, through, first);
+}
+
+/**
+ * floydScalar() qui garde aussi l'indice x du minimum de chaque case, sans branchement (sélection), et met à jour les
+ * successeurs des cases calculées (voir storeHop8()). Les colonnes après la dernière sont remplacées par la dernière :
+ * leurs résultats ne sont pas écrits
+ * @param hops : les successeurs des lignes "W_row"
+ * @param hopsResult : les successeurs des lignes "result"
+ * @param first : l'indice global de la première ligne du processeur
+ */
+void floydPathsScalar(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, struct Hops* hops, struct Hops* hopsResult, int yStart, int yEnd, int nbr_tab, int startZ, int first) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        for (int i = 0; i < nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1 < nbr_tab ? i + 1 : nbr_tab - 1);
+            unsigned int* c2 = ROW(W_column, i + 2 < nbr_tab ? i + 2 : nbr_tab - 1);
+            unsigned int* c3 = ROW(W_column, i + 3 < nbr_tab ? i + 3 : nbr_tab - 1);
+            unsigned int v[FLOYD_COLUMNS] = { INF, INF, INF, INF };
+            int t[FLOYD_COLUMNS] = { 0, 0, 0, 0 };
+            for (int x = 0; x < W_row->stride; x++) {
+                unsigned int r = row[x];
+                unsigned int s0 = sum(r, c0[x]), s1 = sum(r, c1[x]), s2 = sum(r, c2[x]), s3 = sum(r, c3[x]);
+                t[0] = s0 < v[0] ? x : t[0];
+                t[1] = s1 < v[1] ? x : t[1];
+                t[2] = s2 < v[2] ? x : t[2];
+                t[3] = s3 < v[3] ? x : t[3];
+                v[0] = min(v[0], s0);
+                v[1] = min(v[1], s1);
+                v[2] = min(v[2], s2);
+                v[3] = min(v[3], s3);
+            }
+            for (int j = 0; j < FLOYD_COLUMNS && i + j < nbr_tab; j++) {
+                ROW(result, y)[startZ + i + j] = v[j];
+                storeHop(hops, hopsResult, y, startZ + i + j, v[j], t[j], first);
             }
         }
-    } else {
-        MPI_Status status;
-        
-        for (int y = 0; y < nbr_tab; y++) {
-            MPI_Recv(matrix->data[y], tab_size, MPI_INT, previous, tag, MPI_COMM_WORLD, &status);
+    }
+}
+
+#ifdef FLOYD_SIMD
+// Minimum de chaque voie et indice x qui l'a donné : l'indice est remplacé là où le candidat est strictement plus petit
+__attribute__((target("avx2")))
+static inline void argminStep256(__m256i* v, __m256i* t, __m256i candidate, __m256i xs) {
+    __m256i keep = _mm256_cmpeq_epi32(_mm256_max_epu32(candidate, *v), candidate); // candidate >= v
+    *t = _mm256_blendv_epi8(xs, *t, keep);
+    *v = _mm256_min_epu32(*v, candidate);
+}
+
+// Minimum des 8 voies et indice x de l'une des voies qui l'atteignent
+__attribute__((target("avx2")))
+static inline int argmin256(__m256i v, __m256i t, unsigned int* value) {
+    unsigned int values[8];
+    int indices[8];
+    _mm256_storeu_si256((__m256i*) values, v);
+    _mm256_storeu_si256((__m256i*) indices, t);
+    int best = 0;
+    for (int lane = 1; lane < 8; lane++)
+        best = values[lane] < values[best] ? lane : best;
+    *value = values[best];
+    return indices[best];
+}
+
+/**
+ * floydAVX2() qui garde aussi l'indice du minimum (voir floydPathsScalar()) : à côté de chacun des FLOYD_COLUMNS minimums,
+ * un vecteur des indices x, mis à jour par un masque de comparaison
+ */
+__attribute__((target("avx2")))
+void floydPathsAVX2(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, struct Hops* hops, struct Hops* hopsResult, int yStart, int yEnd, int nbr_tab, int startZ, int first) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        for (int i = 0; i < nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1 < nbr_tab ? i + 1 : nbr_tab - 1);
+            unsigned int* c2 = ROW(W_column, i + 2 < nbr_tab ? i + 2 : nbr_tab - 1);
+            unsigned int* c3 = ROW(W_column, i + 3 < nbr_tab ? i + 3 : nbr_tab - 1);
+            __m256i v0 = _mm256_set1_epi32(-1), v1 = v0, v2 = v0, v3 = v0;
+            __m256i t0 = _mm256_setzero_si256(), t1 = t0, t2 = t0, t3 = t0;
+            __m256i xs = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i step = _mm256_set1_epi32(8);
+            for (int x = 0; x < W_row->stride; x += 8) {
+                __m256i r = _mm256_load_si256((__m256i*) (row + x));
+                argminStep256(&v0, &t0, sum256(r, _mm256_load_si256((__m256i*) (c0 + x))), xs);
+                argminStep256(&v1, &t1, sum256(r, _mm256_load_si256((__m256i*) (c1 + x))), xs);
+                argminStep256(&v2, &t2, sum256(r, _mm256_load_si256((__m256i*) (c2 + x))), xs);
+                argminStep256(&v3, &t3, sum256(r, _mm256_load_si256((__m256i*) (c3 + x))), xs);
+                xs = _mm256_add_epi32(xs, step);
+            }
+            unsigned int v[FLOYD_COLUMNS];
+            int t[FLOYD_COLUMNS];
+            t[0] = argmin256(v0, t0, &v[0]);
+            t[1] = argmin256(v1, t1, &v[1]);
+            t[2] = argmin256(v2, t2, &v[2]);
+            t[3] = argmin256(v3, t3, &v[3]);
+            for (int j = 0; j < FLOYD_COLUMNS && i + j < nbr_tab; j++) {
+                ROW(result, y)[startZ + i + j] = v[j];
+                storeHop(hops, hopsResult, y, startZ + i + j, v[j], t[j], first);
+            }
         }
-        
-        int tmp[tab_size];
-        for (int i = rank; i < nbr_procs_used - 1; i++) {
-            for (int y = 0; y < nbr_tab; y++) {
-                MPI_Recv(&tmp, tab_size, MPI_INT, previous, tag, MPI_COMM_WORLD, &status);
-                MPI_Send(&tmp, tab_size, MPI_INT, next, tag, MPI_COMM_WORLD);
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline void argminStep512(__m512i* v, __m512i* t, __m512i candidate, __m512i xs) {
+    __mmask16 less = _mm512_cmplt_epu32_mask(candidate, *v);
+    *t = _mm512_mask_mov_epi32(*t, less, xs);
+    *v = _mm512_min_epu32(*v, candidate);
+}
+
+__attribute__((target("avx512f")))
+static inline int argmin512(__m512i v, __m512i t, unsigned int* value) {
+    *value = _mm512_reduce_min_epu32(v);
+    __mmask16 lanes = _mm512_cmpeq_epu32_mask(v, _mm512_set1_epi32((int) *value));
+    int indices[16];
+    _mm512_storeu_si512(indices, t);
+    return indices[__builtin_ctz(lanes)];
+}
+
+/**
+ * floydAVX512() qui garde aussi l'indice du minimum (voir floydPathsAVX2()) : le masque de comparaison choisit les voies
+ * dont l'indice change
+ */
+__attribute__((target("avx512f")))
+void floydPathsAVX512(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, struct Hops* hops, struct Hops* hopsResult, int yStart, int yEnd, int nbr_tab, int startZ, int first) {
+    #pragma omp parallel for
+    for (int y = yStart; y < yEnd; y++) {
+        unsigned int* row = ROW(W_row, y);
+        for (int i = 0; i < nbr_tab; i += FLOYD_COLUMNS) {
+            unsigned int* c0 = ROW(W_column, i);
+            unsigned int* c1 = ROW(W_column, i + 1 < nbr_tab ? i + 1 : nbr_tab - 1);
+            unsigned int* c2 = ROW(W_column, i + 2 < nbr_tab ? i + 2 : nbr_tab - 1);
+            unsigned int* c3 = ROW(W_column, i + 3 < nbr_tab ? i + 3 : nbr_tab - 1);
+            __m512i v0 = _mm512_set1_epi32(-1), v1 = v0, v2 = v0, v3 = v0;
+            __m512i t0 = _mm512_setzero_si512(), t1 = t0, t2 = t0, t3 = t0;
+            __m512i xs = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            __m512i step = _mm512_set1_epi32(16);
+            for (int x = 0; x < W_row->stride; x += 16) {
+                __m512i r = _mm512_load_si512(row + x);
+                argminStep512(&v0, &t0, sum512(r, _mm512_load_si512(c0 + x)), xs);
+                argminStep512(&v1, &t1, sum512(r, _mm512_load_si512(c1 + x)), xs);
+                argminStep512(&v2, &t2, sum512(r, _mm512_load_si512(c2 + x)), xs);
+                argminStep512(&v3, &t3, sum512(r, _mm512_load_si512(c3 + x)), xs);
+                xs = _mm512_add_epi32(xs, step);
+            }
+            unsigned int v[FLOYD_COLUMNS];
+            int t[FLOYD_COLUMNS];
+            t[0] = argmin512(v0, t0, &v[0]);
+            t[1] = argmin512(v1, t1, &v[1]);
+            t[2] = argmin512(v2, t2, &v[2]);
+            t[3] = argmin512(v3, t3, &v[3]);
+            for (int j = 0; j < FLOYD_COLUMNS && i + j < nbr_tab; j++) {
+                ROW(result, y)[startZ + i + j] = v[j];
+                storeHop(hops, hopsResult, y, startZ + i + j, v[j], t[j], first);
             }
         }
     }
 }
+#endif
 
 /**
- * Permet à un processeur (autre que P0) d'envoyer la matrice résultat à son successeur, et de recevoir du prédécesseur la matrice "result"
- * @param result : la matrice dans laquelle il y a les résultats de la matrice "W" élevée à la puissance N
- * @param previous : le prédécesseur du processeur actuel
- * @param next : le successeur du processeur actuel
- * @param nbr_tab : le nombre de ligne de la matrice
- * @param tab_size : le nombre d'éléments par ligne
- * @param nbr_procs_used : le nombre de processeurs utilisés rééllement par le programme
+ * Produit min-plus des lignes yStart à yEnd et successeurs des cases calculées, dans la même passe, avec le noyau choisi
+ * par chooseKernel() (voir floydPathsScalar())
+ */
+void floydPaths(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, struct Hops* hops, struct Hops* hopsResult, int yStart, int yEnd, int nbr_tab, int startZ, int first) {
+#ifdef FLOYD_SIMD
+    if (kernel == KERNEL_AVX512)
+        floydPathsAVX512(W_row, W_column, result, hops, hopsResult, yStart, yEnd, nbr_tab, startZ, first);
+    else if (kernel == KERNEL_AVX2)
+        floydPathsAVX2(W_row, W_column, result, hops, hopsResult, yStart, yEnd, nbr_tab, startZ, first);
+    else
+#endif
+        floydPathsScalar(W_row, W_column, result, hops, hopsResult, yStart, yEnd, nbr_tab, startZ, first);
+}
+
+/**
+ * Récupération par P0 des successeurs de tous les processeurs (MPI_Gatherv), comme gather() pour les distances
+ * @param hops : les successeurs des lignes du processeur
+ * @param all : les successeurs de toute la matrice (P0 seulement)
+ * @param counts : le nombre de lignes de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
  * @param rank : le rang du processeur qui appelle la méthode
  * @return void
  */
-void gather(struct Matrix* result, int previous, int next, int nbr_tab, int tab_size, int rank) {
-    MPI_Status status;
+void gatherHops(struct Hops* hops, struct Hops* all, int* counts, int* displs, int nbr_procs, int rank) {
+    int row = hops->width * hops->columns;
+    int* recvcounts = malloc(sizeof(int) * nbr_procs);
+    int* recvdispls = malloc(sizeof(int) * nbr_procs);
     
-    for (int y = nbr_tab - 1; y >= 0; y--) {
-        MPI_Send(result->data[y], tab_size, MPI_INT, next, TAG_GATHER, MPI_COMM_WORLD);
+    for (int r = 0; r < nbr_procs; r++) {
+        recvcounts[r] = row * counts[r];
+        recvdispls[r] = row * displs[r];
     }
+    if (rank != 0 && counts[rank] > 0)
+        nbr_messages++;
     
-    int tmp[tab_size];
-    for (int i = 0; i < rank - 1; i++) {
-        for (int y = 0; y < nbr_tab; y++) {
-            MPI_Recv(&tmp, tab_size, MPI_INT, previous, TAG_GATHER, MPI_COMM_WORLD, &status);
-            MPI_Send(&tmp, tab_size, MPI_INT, next, TAG_GATHER, MPI_COMM_WORLD);
-        }
-    }
+    MPI_Gatherv(hops->data, recvcounts[rank], MPI_BYTE, rank == 0 ? all->data : NULL, recvcounts, recvdispls, MPI_BYTE, 0, MPI_COMM_WORLD);
+    
+    free(recvcounts);
+    free(recvdispls);
 }
 
 /**
- * Permet à P0 de récupérer toutes les lignes et des les placer au bon endroit dans sa matrice
- * @param result : la matrice dans laquelle on va stocker le résultat des matrices résultats des autres processeurs
- * @param previous : le prédécesseur du processeur actuel
- * @param nbr_tab : le nombre de ligne de la matrice
- * @param tab_size : le nombre d'éléments par ligne
- * @param nbr_procs_used : le nombre de processeurs utilisés rééllement par le programme
+ * Affiche le plus court chemin et la distance de chaque couple "source destination" d'un fichier (--query), à partir des
+ * successeurs, sans nouveau calcul
+ * @param filePath : le fichier des couples (un par ligne, sommets numérotés à partir de 0)
+ * @param result : la matrice des distances
+ * @param hops : la matrice des successeurs
  * @return void
  */
-void gatherFinal(struct Matrix* result, int previous, int nbr_tab, int tab_size, int nbr_procs_used) {
-    MPI_Status status;
+void queryPaths(char* filePath, struct Matrix* result, struct Hops* hops) {
+    FILE* file;
+    int source;
+    int destination;
+    
+    if ((file = fopen(filePath, "r")) == NULL) {
+        printf("Erreur sur l'ouverture du fichier %s\n", filePath);
+        exit(1);
+    }
     
-    for (int i = nbr_procs_used - 1; i > 0 ; i--) {
-        for (int j = 0; j < nbr_tab; j++) {
-            MPI_Recv(result->data[nbr_tab + (nbr_tab * i) - j - 1], tab_size, MPI_INT, previous, TAG_GATHER, MPI_COMM_WORLD, &status);
+    while (fscanf(file, "%d %d", &source, &destination) == 2) {
+        if (source < 0 || destination < 0 || source >= hops->columns || destination >= hops->columns) {
+            printf("%d %d : sommet inconnu\n", source, destination);
+        } else if (ROW(result, source)[destination] == INF) {
+            printf("%d %d : aucun chemin\n", source, destination);
+        } else {
+            if (hops->width == 1)
+                printPath8(hops, source, destination);
+            else if (hops->width == 2)
+                printPath16(hops, source, destination);
+            else
+                printPath32(hops, source, destination);
+            printf(" : %u\n", ROW(result, source)[destination]);
         }
     }
+    
+    fclose(file);
 }
 
 /**
- * Envoie une matrice au successeur et reçoit une matrice de son prédécesseur
- * @param W_column : la matrice à envoyer / recevoir
- * @param nbr_tab : le nombre de ligne de la matrice
- * @param tab_size : le nombre d'éléments par ligne
+ * Produit min-plus des lignes "W_row" par toutes les colonnes de la matrice : la matrice colonne "W_column" fait un tour
+ * complet de l'anneau et revient à son processeur. Double tampon : à chaque étape, le bloc de colonnes est envoyé au
+ * successeur (MPI_Isend) pendant que le bloc suivant arrive du prédécesseur dans "buffer" (MPI_Irecv) et que le bloc
+ * actuel est multiplié, RING_CHUNK lignes à la fois. Entre deux paquets de lignes, MPI_Testall fait avancer les messages
+ * (MPI_THREAD_FUNNELED : les appels MPI restent hors des régions parallèles). La durée des messages est ajoutée à
+ * "comm_hidden" tant que le calcul continue, et à "comm_exposed" pour l'attente après le calcul
+ * @param W_row : les lignes du processeur
+ * @param W_column : les colonnes du processeur, qui circulent entre tous les processeurs
+ * @param buffer : une matrice de la taille de "W_column" pour recevoir les colonnes, échangée ensuite avec "W_column"
+ * @param result : la matrice dans laquelle on va stocker les résultats
+ * @param nbr_tab : le nombre de ligne du processeur
  * @param previous : le prédécesseur du processeur actuel
  * @param next : le successeur du processeur actuel
+ * @param counts : le nombre de lignes (et de colonnes) de chaque processeur, "W_column" et "buffer" en contiennent counts[0]
+ * @param displs : l'indice de la première ligne (et colonne) de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @param hops : les successeurs des lignes "W_row" (NULL sans --paths)
+ * @param hopsResult : les successeurs des lignes "result", calculés dans la même passe que les distances (voir floydPaths())
  * @return void
  */
-void circulate(struct Matrix* W_column, int nbr_tab, int tab_size, int next, int previous) {
-    MPI_Status status;
+void ringProduct(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* buffer, struct Matrix* result, int nbr_tab, int next, int previous, int* counts, int* displs, int nbr_procs, int rank, struct Hops* hops, struct Hops* hopsResult) {
+    MPI_Request requests[2];
     
-    for (int i = 0; i < nbr_tab; i++) {
-        MPI_Send(W_column->data[i], tab_size, MPI_INT, next, TAG_CIRCULATE, MPI_COMM_WORLD);
-        MPI_Recv(W_column->data[i], tab_size, MPI_INT, previous, TAG_CIRCULATE, MPI_COMM_WORLD, &status);
+    // À l'étape i, le processeur tient les colonnes du processeur rank - i
+    for (int i = 0; i < nbr_procs; i++) {
+        int owner = (rank - i + nbr_procs) % nbr_procs;
+        int sender = (owner - 1 + nbr_procs) % nbr_procs;
+        double start = MPI_Wtime();
+        double arrived = 0;
+        int done = 0;
+        
+        MPI_Irecv(buffer->data, blockCount(buffer, counts[sender]), MPI_UNSIGNED, previous, TAG_CIRCULATE, MPI_COMM_WORLD, &requests[0]);
+        MPI_Isend(W_column->data, blockCount(W_column, counts[owner]), MPI_UNSIGNED, next, TAG_CIRCULATE, MPI_COMM_WORLD, &requests[1]);
+        nbr_messages++;
+        
+        for (int y = 0; y < nbr_tab; y += RING_CHUNK) {
+            int yEnd = y + RING_CHUNK < nbr_tab ? y + RING_CHUNK : nbr_tab;
+            if (hops == NULL)
+                floydRows(W_row, W_column, result, y, yEnd, counts[owner], displs[owner]);
+            else
+                floydPaths(W_row, W_column, result, hops, hopsResult, y, yEnd, counts[owner], displs[owner], displs[rank]);
+            if (!done) {
+                MPI_Testall(2, requests, &done, MPI_STATUSES_IGNORE);
+                arrived = MPI_Wtime();
+            }
+        }
+        
+        double computed = MPI_Wtime();
+        if (done) {
+            comm_hidden += arrived - start;
+        } else {
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+            arrived = MPI_Wtime();
+            comm_hidden += computed - start;
+            comm_exposed += arrived - computed;
+        }
+        
+        unsigned int* received = buffer->data;
+        buffer->data = W_column->data;
+        W_column->data = received;
     }
 }
 
@@ -304,142 +999,1049 @@ void circulate(struct Matrix* W_column, int nbr_tab, int tab_size, int next, int
  * @param W_row : la matrice à élever à la puissance N
  * @param W_column : la matrice à envoyer / recevoir utilisée pour élever "W_row" à la puissance N
  * @param result : la matrice dans laquelle on va stocker les résultats
- * @param nbr_tab : le nombre de ligne de la matrice
+ * @param nbr_tab : le nombre de ligne du processeur
  * @param tab_size : le nombre d'éléments par ligne
  * @param previous : le prédécesseur du processeur actuel
  * @param next : le successeur du processeur actuel
- * @param nbr_procs_used : le nombre de processeurs utilisés rééllement par le programme
+ * @param counts : le nombre de lignes de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
  * @param rank : le rang du processeur qui appelle la méthode
+ * @param nbr_products : le nombre de produits à effectuer (tab_size - 1 pour obtenir les plus courts chemins)
+ * @param hops : les successeurs des lignes de W, remplacés par ceux des lignes du résultat (NULL sans --paths)
  * @return void
  */
-void elevateToN(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int nbr_tab, int tab_size, int next, int previous, int nbr_procs_used, int rank) {
-    for (int n = 0; n < tab_size - 1; n++) {
-        if (n != 0) {
-            #pragma omp parallel for
-            for (int y = 0; y < nbr_tab; y++) {
-                #pragma omp parallel for
-                for (int x = 0; x < tab_size; x++)
-                    W_row->data[y][x] = result->data[y][x];
-            }
-        }
-        for (int i = nbr_procs_used; i > 0; i--) {
-            if (rank == 0)
-                floyd(W_row, W_column, result, nbr_tab, (nbr_tab * i) % tab_size);
-            else
-                floyd(W_row, W_column, result, nbr_tab, ((nbr_tab * (i + rank)) % tab_size));
-            circulate(W_column, nbr_tab, tab_size, next, previous);
-        }
+void elevateToN(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int nbr_tab, int tab_size, int next, int previous, int* counts, int* displs, int nbr_procs, int rank, int nbr_products, struct Hops* hops) {
+    struct Matrix* buffer = allocateMatrix(tab_size, counts[0]);
+    struct Hops* hopsResult = hops == NULL ? NULL : allocateHops(tab_size, nbr_tab);
+    
+    for (int n = 0; n < nbr_products; n++) {
+        // Mêmes colonnes et même stride : les lignes du résultat se recopient d'un bloc (P0 garde toute la matrice dans
+        // "result" pour gather(), les deux tableaux ne peuvent donc pas être échangés)
+        if (n != 0)
+            memcpy(W_row->data, result->data, sizeof(unsigned int) * blockCount(result, nbr_tab));
+        ringProduct(W_row, W_column, buffer, result, nbr_tab, next, previous, counts, displs, nbr_procs, rank, hops, hopsResult);
+        swapHops(hops, hopsResult);
     }
+    
+    freeMatrix(buffer);
+    freeHops(hopsResult);
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
+/**
+ * Remplace les colonnes du processeur par celles de la matrice dont chaque processeur vient de calculer ses lignes : le bloc
+ * (lignes de P_s, colonnes de P_r) est transposé par P_s puis envoyé à P_r, en un seul MPI_Alltoallv
+ * @param result : les lignes calculées par le processeur
+ * @param W_column : les colonnes du processeur, remplacées
+ * @param counts : le nombre de lignes (et de colonnes) de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne (et colonne) de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @return void
+ */
+void exchangeColumns(struct Matrix* result, struct Matrix* W_column, int* counts, int* displs, int nbr_procs, int rank) {
+    int nbr_tab = counts[rank];
+    int* sendcounts = malloc(sizeof(int) * nbr_procs);
+    int* senddispls = malloc(sizeof(int) * nbr_procs);
+    int* recvcounts = malloc(sizeof(int) * nbr_procs);
+    int* recvdispls = malloc(sizeof(int) * nbr_procs);
+    
+    for (int s = 0; s < nbr_procs; s++) {
+        sendcounts[s] = nbr_tab * counts[s];
+        recvcounts[s] = counts[s] * nbr_tab;
+        senddispls[s] = s == 0 ? 0 : senddispls[s - 1] + sendcounts[s - 1];
+        recvdispls[s] = s == 0 ? 0 : recvdispls[s - 1] + recvcounts[s - 1];
+        if (s != rank && sendcounts[s] > 0)
+            nbr_messages++;
+    }
+    
+    size_t total = (size_t) nbr_tab * displs[nbr_procs - 1] + (size_t) nbr_tab * counts[nbr_procs - 1];
+    unsigned int* send = malloc(sizeof(unsigned int) * (total > 0 ? total : 1));
+    unsigned int* receive = malloc(sizeof(unsigned int) * (total > 0 ? total : 1));
+    
+    #pragma omp parallel for
+    for (int s = 0; s < nbr_procs; s++) {
+        for (int c = 0; c < counts[s]; c++) {
+            for (int y = 0; y < nbr_tab; y++)
+                send[senddispls[s] + (size_t) c * nbr_tab + y] = ROW(result, y)[displs[s] + c];
+        }
+    }
+    
+    MPI_Alltoallv(send, sendcounts, senddispls, MPI_UNSIGNED, receive, recvcounts, recvdispls, MPI_UNSIGNED, MPI_COMM_WORLD);
+    
+    #pragma omp parallel for
+    for (int c = 0; c < nbr_tab; c++) {
+        for (int s = 0; s < nbr_procs; s++)
+            memcpy(ROW(W_column, c) + displs[s], receive + recvdispls[s] + (size_t) c * counts[s], sizeof(unsigned int) * counts[s]);
+    }
+    
+    free(send);
+    free(receive);
+    free(sendcounts);
+    free(senddispls);
+    free(recvcounts);
+    free(recvdispls);
+}
+
+/**
+ * Indique si une distance a changé sur au moins un processeur (MPI_Allreduce)
+ * @param before : les lignes avant le produit
+ * @param after : les lignes après le produit
+ * @param nbr_tab : le nombre de ligne de la matrice
+ * @param tab_size : le nombre d'éléments par ligne
+ * @return 1 si une distance a changé, 0 sinon
+ */
+int hasChanged(struct Matrix* before, struct Matrix* after, int nbr_tab, int tab_size) {
+    int changed = 0;
+    
+    #pragma omp parallel for reduction(||:changed)
+    for (int y = 0; y < nbr_tab; y++) {
+        for (int x = 0; x < tab_size; x++) {
+            if (ROW(before, y)[x] != ROW(after, y)[x])
+                changed = 1;
+        }
+    }
+    
+    int global;
+    MPI_Allreduce(&changed, &global, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    
+    return global;
+}
+
+/**
+ * Nombre d'élévations au carré nécessaires pour que W^(2^k) contienne les chemins d'au plus N - 1 arcs
+ * @param tab_size : le nombre de sommets N
+ * @return ⌈log2(N - 1)⌉, et au moins 1
+ */
+int squaringCount(int tab_size) {
+    int count = 1;
+    
+    while ((1L << count) < tab_size - 1)
+        count++;
+    
+    return count;
+}
+
+/**
+ * Calcule les plus courts chemins par élévations au carré successives : W^2, W^4, ... en au plus ⌈log2(N - 1)⌉ produits sur
+ * l'anneau (W^k contient les plus courts chemins d'au plus k arcs, la diagonale étant nulle). Le calcul s'arrête dès qu'un
+ * produit ne change plus aucune distance
+ * @param W_row : les lignes du processeur
+ * @param W_column : les colonnes du processeur
+ * @param result : la matrice dans laquelle on va stocker les résultats
+ * @param nbr_tab : le nombre de ligne du processeur
+ * @param tab_size : le nombre d'éléments par ligne
+ * @param previous : le prédécesseur du processeur actuel
+ * @param next : le successeur du processeur actuel
+ * @param counts : le nombre de lignes de chaque processeur (voir distribute())
+ * @param displs : l'indice de la première ligne de chaque processeur
+ * @param nbr_procs : le nombre de processeurs
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @param nbr_products : le nombre maximal de produits
+ * @param hops : les successeurs des lignes de W, remplacés par ceux des lignes du résultat (NULL sans --paths)
+ * @return le nombre de produits effectués
+ */
+int squareToN(struct Matrix* W_row, struct Matrix* W_column, struct Matrix* result, int nbr_tab, int tab_size, int next, int previous, int* counts, int* displs, int nbr_procs, int rank, int nbr_products, struct Hops* hops) {
+    struct Matrix* buffer = allocateMatrix(tab_size, counts[0]);
+    struct Hops* hopsResult = hops == NULL ? NULL : allocateHops(tab_size, nbr_tab);
+    int n = 0;
+    
+    while (n < nbr_products) {
+        if (n != 0) {
+            memcpy(W_row->data, result->data, sizeof(unsigned int) * blockCount(result, nbr_tab));
+            exchangeColumns(result, W_column, counts, displs, nbr_procs, rank);
+        }
+        ringProduct(W_row, W_column, buffer, result, nbr_tab, next, previous, counts, displs, nbr_procs, rank, hops, hopsResult);
+        swapHops(hops, hopsResult);
+        n++;
+        
+        if (!hasChanged(W_row, result, nbr_tab, tab_size))
+            break;
+    }
+    
+    freeMatrix(buffer);
+    freeHops(hopsResult);
+    
+    return n;
+}
+
+/**
+ * Relâche les chemins d'un carreau de D par chacun des sommets intermédiaires k de [kStart, kEnd[ (cœur de l'algorithme de
+ * Floyd-Warshall). Le carreau peut contenir les lignes ou les colonnes k : D[k][k] vaut 0, elles ne changent donc pas
+ * @param D : la matrice des distances
+ * @param iStart : la première ligne du carreau
+ * @param iEnd : la fin (exclue) des lignes du carreau
+ * @param jStart : la première colonne du carreau
+ * @param jEnd : la fin (exclue) des colonnes du carreau
+ * @param kStart : le premier sommet intermédiaire
+ * @param kEnd : la fin (exclue) des sommets intermédiaires
+ * @return void
+ */
+void relaxTile(struct Matrix* D, int iStart, int iEnd, int jStart, int jEnd, int kStart, int kEnd) {
+    for (int k = kStart; k < kEnd; k++) {
+        unsigned int* through = ROW(D, k);
+        for (int i = iStart; i < iEnd; i++) {
+            unsigned int* row = ROW(D, i);
+            unsigned int distance = row[k];
+            if (distance == INF)
+                continue;
+            for (int j = jStart; j < jEnd; j++)
+                row[j] = min(row[j], sum(distance, through[j]));
+        }
+    }
+}
+
+/**
+ * Algorithme de Floyd-Warshall par blocs sur un seul nœud, en O(n^3) : à chaque tour, le carreau diagonal, puis les carreaux
+ * de sa ligne et de sa colonne, puis tous les autres. Chaque carreau est une tâche OpenMP ; les dépendances (une case de
+ * 'tokens' par carreau) laissent un tour commencer dès que les carreaux qu'il lit sont prêts
+ * @param D : la matrice W, remplacée par la matrice des plus courts chemins
+ * @param tile : le côté des carreaux
+ * @return void
+ */
+void blockedFloyd(struct Matrix* D, int tile) {
+    int n = D->rows;
+    int nbr_tiles = (n + tile - 1) / tile;
+    char* tokens = malloc((size_t) nbr_tiles * nbr_tiles + 1);
+    
+    #pragma omp parallel
+    #pragma omp single
+    for (int kb = 0; kb < nbr_tiles; kb++) {
+        int k0 = kb * tile;
+        int k1 = (k0 + tile < n) ? k0 + tile : n;
+        
+        // Carreau diagonal
+        #pragma omp task depend(inout: tokens[kb * nbr_tiles + kb])
+        relaxTile(D, k0, k1, k0, k1, k0, k1);
+        
+        // Carreaux de la ligne et de la colonne du carreau diagonal
+        for (int b = 0; b < nbr_tiles; b++) {
+            if (b == kb)
+                continue;
+            int b0 = b * tile;
+            int b1 = (b0 + tile < n) ? b0 + tile : n;
+            
+            #pragma omp task depend(in: tokens[kb * nbr_tiles + kb]) depend(inout: tokens[kb * nbr_tiles + b])
+            relaxTile(D, k0, k1, b0, b1, k0, k1);
+            #pragma omp task depend(in: tokens[kb * nbr_tiles + kb]) depend(inout: tokens[b * nbr_tiles + kb])
+            relaxTile(D, b0, b1, k0, k1, k0, k1);
+        }
+        
+        // Autres carreaux
+        for (int ib = 0; ib < nbr_tiles; ib++) {
+            if (ib == kb)
+                continue;
+            int i0 = ib * tile;
+            int i1 = (i0 + tile < n) ? i0 + tile : n;
+            
+            for (int jb = 0; jb < nbr_tiles; jb++) {
+                if (jb == kb)
+                    continue;
+                int j0 = jb * tile;
+                int j1 = (j0 + tile < n) ? j0 + tile : n;
+                
+                #pragma omp task depend(in: tokens[ib * nbr_tiles + kb], tokens[kb * nbr_tiles + jb]) depend(inout: tokens[ib * nbr_tiles + jb])
+                relaxTile(D, i0, i1, j0, j1, k0, k1);
+            }
+        }
+    }
+    
+    free(tokens);
+}
+
+// Tas radix (clés croissantes) : le paquet i contient les clés dont le bit de poids fort qui diffère de "last" est le bit
+// i - 1 (paquet 0 : clés égales à "last"). Extraire vide le premier paquet non vide en redistribuant ses clés vers des
+// paquets plus petits ; chaque clé descend au plus 32 fois
+struct RadixHeap {
+    unsigned int* keys[RADIX_BUCKETS];
+    int* vertices[RADIX_BUCKETS];
+    int sizes[RADIX_BUCKETS];
+    int capacities[RADIX_BUCKETS];
+    unsigned int last; // Dernière clé extraite
+    int size;
+};
+
+struct RadixHeap* allocateHeap() {
+    struct RadixHeap* heap = malloc(sizeof(struct RadixHeap));
+    heap->last = 0;
+    heap->size = 0;
+    
+    for (int i = 0; i < RADIX_BUCKETS; i++) {
+        heap->sizes[i] = 0;
+        heap->capacities[i] = 16;
+        heap->keys[i] = malloc(sizeof(unsigned int) * heap->capacities[i]);
+        heap->vertices[i] = malloc(sizeof(int) * heap->capacities[i]);
+    }
+    
+    return heap;
+}
+
+void freeHeap(struct RadixHeap* heap) {
+    for (int i = 0; i < RADIX_BUCKETS; i++) {
+        free(heap->keys[i]);
+        free(heap->vertices[i]);
+    }
+    free(heap);
+}
+
+void heapPush(struct RadixHeap* heap, unsigned int key, int vertex) {
+    int i = key == heap->last ? 0 : 32 - __builtin_clz(key ^ heap->last);
+    
+    if (heap->sizes[i] == heap->capacities[i]) {
+        heap->capacities[i] *= 2;
+        heap->keys[i] = realloc(heap->keys[i], sizeof(unsigned int) * heap->capacities[i]);
+        heap->vertices[i] = realloc(heap->vertices[i], sizeof(int) * heap->capacities[i]);
+    }
+    heap->keys[i][heap->sizes[i]] = key;
+    heap->vertices[i][heap->sizes[i]] = vertex;
+    heap->sizes[i]++;
+    heap->size++;
+}
+
+/**
+ * Extrait une clé minimale du tas (non vide)
+ * @param heap : le tas
+ * @param vertex : le sommet associé à la clé
+ * @return la clé
+ */
+unsigned int heapPop(struct RadixHeap* heap, int* vertex) {
+    if (heap->sizes[0] == 0) {
+        int i = 1;
+        while (heap->sizes[i] == 0)
+            i++;
+        
+        unsigned int smallest = heap->keys[i][0];
+        for (int k = 1; k < heap->sizes[i]; k++)
+            smallest = min(smallest, heap->keys[i][k]);
+        heap->last = smallest;
+        
+        // Les clés du paquet i partagent avec la nouvelle "last" plus de bits de poids fort : elles passent dans des paquets < i
+        int count = heap->sizes[i];
+        heap->sizes[i] = 0;
+        heap->size -= count;
+        for (int k = 0; k < count; k++)
+            heapPush(heap, heap->keys[i][k], heap->vertices[i][k]);
+    }
+    
+    heap->sizes[0]--;
+    heap->size--;
+    *vertex = heap->vertices[0][heap->sizes[0]];
+    
+    return heap->keys[0][heap->sizes[0]];
+}
+
+/**
+ * Plus courts chemins depuis un sommet (Dijkstra avec un tas radix, les entrées périmées du tas sont ignorées)
+ * @param graph : le graphe
+ * @param source : le sommet de départ
+ * @param distances : les distances depuis "source" (une ligne de la matrice résultat)
+ * @param heap : un tas vide
+ * @return void
+ */
+void dijkstra(struct Graph* graph, int source, unsigned int* distances, struct RadixHeap* heap) {
+    for (int x = 0; x < graph->vertices; x++)
+        distances[x] = INF;
+    distances[source] = 0;
+    heap->last = 0;
+    heapPush(heap, 0, source);
+    
+    while (heap->size > 0) {
+        int y;
+        unsigned int distance = heapPop(heap, &y);
+        if (distance != distances[y])
+            continue;
+        for (int e = graph->offsets[y]; e < graph->offsets[y + 1]; e++) {
+            unsigned int through = sum(distance, graph->weights[e]);
+            if (through < distances[graph->targets[e]]) {
+                distances[graph->targets[e]] = through;
+                heapPush(heap, through, graph->targets[e]);
+            }
+        }
+    }
+}
+
+/**
+ * Envoie le graphe de P0 à tous les processeurs (MPI_Bcast de la taille puis des trois tableaux CSR)
+ * @param graph : le graphe de P0, NULL sur les autres processeurs
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @param nbr_procs : le nombre de processeurs
+ * @return le graphe (celui de P0 sur P0, une copie ailleurs)
+ */
+struct Graph* broadcastGraph(struct Graph* graph, int rank, int nbr_procs) {
+    int sizes[2];
+    
+    if (rank == 0) {
+        sizes[0] = graph->vertices;
+        sizes[1] = graph->edges;
+        nbr_messages += 3 * (nbr_procs - 1);
+    }
+    MPI_Bcast(sizes, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    
+    if (rank != 0) {
+        graph = malloc(sizeof(struct Graph));
+        graph->vertices = sizes[0];
+        graph->edges = sizes[1];
+        graph->offsets = malloc(sizeof(int) * (sizes[0] + 1));
+        graph->targets = malloc(sizeof(int) * (sizes[1] > 0 ? sizes[1] : 1));
+        graph->weights = malloc(sizeof(unsigned int) * (sizes[1] > 0 ? sizes[1] : 1));
+    }
+    MPI_Bcast(graph->offsets, sizes[0] + 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(graph->targets, sizes[1], MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(graph->weights, sizes[1], MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    
+    return graph;
+}
+
+/**
+ * Moteur creux (--sparse) : Dijkstra depuis chacun des sommets du processeur (répartis comme les lignes, voir
+ * distribute()), les sommets étant distribués dynamiquement entre les threads qui ont chacun leur tas. En O(N (M + N log C))
+ * au lieu de O(N^3) par produit min-plus
+ * @param graph : le graphe
+ * @param result : les lignes du processeur (une par sommet de départ)
+ * @param first : le premier sommet de départ du processeur
+ * @param nbr_tab : le nombre de sommets de départ du processeur
+ * @return void
+ */
+void sparseAPSP(struct Graph* graph, struct Matrix* result, int first, int nbr_tab) {
+    #pragma omp parallel
+    {
+        struct RadixHeap* heap = allocateHeap();
+        
+        #pragma omp for schedule(dynamic)
+        for (int y = 0; y < nbr_tab; y++)
+            dijkstra(graph, first + y, ROW(result, y), heap);
+        
+        freeHeap(heap);
+    }
+}
+
+// Grille q x q de processeurs pour --grid (voir gridToN())
+struct Grid {
+    MPI_Comm comm; // Communicateur cartésien (rangs identiques à MPI_COMM_WORLD)
+    MPI_Comm row; // Processeurs de la même ligne de la grille, le rang est la colonne
+    MPI_Comm column; // Processeurs de la même colonne de la grille, le rang est la ligne
+    int q;
+    int i; // Ligne du processeur dans la grille
+    int j; // Colonne du processeur dans la grille
+};
+
+/**
+ * Création de la grille de processeurs (MPI_Cart_create, périodique dans les deux dimensions) et des communicateurs de
+ * ligne et de colonne (MPI_Cart_sub)
+ * @param nbr_procs : le nombre de processeurs, un carré (vérifié par main())
+ * @return la grille
+ */
+struct Grid createGrid(int nbr_procs) {
+    struct Grid grid;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    grid.q = 1;
+    while ((grid.q + 1) * (grid.q + 1) <= nbr_procs)
+        grid.q++;
+    
+    int dims[2] = { grid.q, grid.q };
+    int periods[2] = { 1, 1 };
+    int coords[2];
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid.comm);
+    MPI_Comm_rank(grid.comm, &rank);
+    MPI_Cart_coords(grid.comm, rank, 2, coords);
+    grid.i = coords[0];
+    grid.j = coords[1];
+    
+    int keepRow[2] = { 0, 1 };
+    int keepColumn[2] = { 1, 0 };
+    MPI_Cart_sub(grid.comm, keepRow, &grid.row);
+    MPI_Cart_sub(grid.comm, keepColumn, &grid.column);
+    
+    return grid;
+}
+
+void freeGrid(struct Grid* grid) {
+    MPI_Comm_free(&grid->row);
+    MPI_Comm_free(&grid->column);
+    MPI_Comm_free(&grid->comm);
+}
+
+/**
+ * Décale les blocs d'une ligne ou d'une colonne de la grille : le processeur de rang r reçoit le bloc du rang r + shift
+ * @param block : le bloc à envoyer / recevoir
+ * @param buffer : un bloc de même taille qui reçoit, échangé ensuite avec "block" (voir ringProduct())
+ * @param block_size : le côté des blocs
+ * @param shift : le décalage
+ * @param comm : le communicateur de ligne ou de colonne
+ * @return void
+ */
+void shiftBlock(struct Matrix* block, struct Matrix* buffer, int block_size, int shift, MPI_Comm comm) {
+    int rank;
+    int size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (shift % size == 0)
+        return;
+    
+    MPI_Status status;
+    int count = blockCount(block, block_size);
+    
+    MPI_Sendrecv(block->data, count, MPI_UNSIGNED, (rank - shift % size + size) % size, TAG_SHIFT, buffer->data, count, MPI_UNSIGNED, (rank + shift) % size, TAG_SHIFT, comm, &status);
+    nbr_messages++;
+    
+    unsigned int* received = buffer->data;
+    buffer->data = block->data;
+    block->data = received;
+}
+
+/**
+ * Distribution de W par blocs : le processeur (i, j) reçoit le bloc de lignes i et de colonnes j, complété par des INF
+ * au-delà des N sommets (MPI_Scatter)
+ * @param W : la matrice à distribuer (P0 seulement)
+ * @param block : le bloc du processeur
+ * @param tab_size : le nombre de sommets N
+ * @param block_size : le côté des blocs
+ * @param grid : la grille de processeurs
+ * @return void
+ */
+void scatterBlocks(struct Matrix* W, struct Matrix* block, int tab_size, int block_size, struct Grid* grid) {
+    int count = blockCount(block, block_size);
+    int rank;
+    unsigned int* send = NULL;
+    MPI_Comm_rank(grid->comm, &rank);
+    
+    if (rank == 0) {
+        int nbr_procs = grid->q * grid->q;
+        send = malloc(sizeof(unsigned int) * (size_t) count * nbr_procs);
+        
+        #pragma omp parallel for
+        for (int r = 0; r < nbr_procs; r++) {
+            int coords[2] = { r / grid->q, r % grid->q }; // Rangs de la grille dans l'ordre des lignes (MPI_Cart_coords())
+            for (int y = 0; y < block_size; y++) {
+                unsigned int* row = send + (size_t) r * count + (size_t) y * block->stride;
+                int gy = coords[0] * block_size + y;
+                for (int x = 0; x < block->stride; x++) {
+                    int gx = coords[1] * block_size + x;
+                    row[x] = (x < block_size && gy < tab_size && gx < tab_size) ? ROW(W, gy)[gx] : INF;
+                }
+            }
+        }
+        nbr_messages += nbr_procs - 1;
+    }
+    
+    MPI_Scatter(send, count, MPI_UNSIGNED, block->data, count, MPI_UNSIGNED, 0, grid->comm);
+    
+    free(send);
+}
+
+/**
+ * Récupération des blocs par P0 (MPI_Gather), sans les cases de complétion
+ * @param block : le bloc du processeur
+ * @param result : la matrice N x N reconstituée (P0 seulement)
+ * @param tab_size : le nombre de sommets N
+ * @param block_size : le côté des blocs
+ * @param grid : la grille de processeurs
+ * @return void
+ */
+void gatherBlocks(struct Matrix* block, struct Matrix* result, int tab_size, int block_size, struct Grid* grid) {
+    int count = blockCount(block, block_size);
+    int rank;
+    unsigned int* receive = NULL;
+    MPI_Comm_rank(grid->comm, &rank);
+    
+    if (rank == 0)
+        receive = malloc(sizeof(unsigned int) * (size_t) count * grid->q * grid->q);
+    else
+        nbr_messages++;
+    
+    MPI_Gather(block->data, count, MPI_UNSIGNED, receive, count, MPI_UNSIGNED, 0, grid->comm);
+    
+    if (rank == 0) {
+        #pragma omp parallel for
+        for (int r = 0; r < grid->q * grid->q; r++) {
+            int coords[2] = { r / grid->q, r % grid->q }; // Rangs de la grille dans l'ordre des lignes (MPI_Cart_coords())
+            for (int y = 0; y < block_size && coords[0] * block_size + y < tab_size; y++) {
+                unsigned int* row = receive + (size_t) r * count + (size_t) y * block->stride;
+                for (int x = 0; x < block_size && coords[1] * block_size + x < tab_size; x++)
+                    ROW(result, coords[0] * block_size + y)[coords[1] * block_size + x] = row[x];
+            }
+        }
+    }
+    
+    free(receive);
+}
+
+/**
+ * Produit min-plus de Cannon sur la grille : C = A x B, avec A et B déjà décalés (le processeur (i, j) tient A(i, i + j) et
+ * B(i + j, j)). À chaque étape, chaque processeur multiplie ses blocs, puis les blocs de A se décalent d'un cran vers la
+ * gauche et ceux de B d'un cran vers le haut ; après q étapes, ils sont revenus à leur place. Chaque processeur envoie
+ * 2q blocs de (N / q)^2 cases par produit, soit O(N^2 / √p) au lieu de O(N^2) sur l'anneau
+ * @param A : le bloc de lignes
+ * @param BT : le bloc de colonnes, transposé (les colonnes de B sont rangées en lignes, comme "W_column" pour floyd())
+ * @param result : le bloc C calculé
+ * @param partial : un bloc de travail pour le produit d'une étape
+ * @param buffer : un bloc pour recevoir les décalages (voir shiftBlock())
+ * @param block_size : le côté des blocs
+ * @param grid : la grille de processeurs
+ * @return void
+ */
+void cannonProduct(struct Matrix* A, struct Matrix* BT, struct Matrix* result, struct Matrix* partial, struct Matrix* buffer, int block_size, struct Grid* grid) {
+    for (int step = 0; step < grid->q; step++) {
+        floyd(A, BT, step == 0 ? result : partial, block_size, 0);
+        if (step != 0) {
+            #pragma omp parallel for
+            for (int y = 0; y < block_size; y++) {
+                for (int x = 0; x < block_size; x++)
+                    ROW(result, y)[x] = min(ROW(result, y)[x], ROW(partial, y)[x]);
+            }
+        }
+        shiftBlock(A, buffer, block_size, 1, grid->row);
+        shiftBlock(BT, buffer, block_size, 1, grid->column);
+    }
+}
+
+/**
+ * Transposition d'un bloc dans un autre (les cases de complétion de "transpose" ne sont pas modifiées)
+ * @param block : le bloc à transposer
+ * @param transpose : le bloc transposé
+ * @param block_size : le côté des blocs
+ * @return void
+ */
+void transposeBlock(struct Matrix* block, struct Matrix* transpose, int block_size) {
+    #pragma omp parallel for
+    for (int y = 0; y < block_size; y++) {
+        for (int x = 0; x < block_size; x++)
+            ROW(transpose, x)[y] = ROW(block, y)[x];
+    }
+}
+
+/**
+ * Élève W à la puissance N sur la grille (--grid) : D = D x W à chaque produit, ou D = D x D avec --squaring (arrêt dès qu'un
+ * produit ne change plus aucune distance, voir squareToN()). Chaque produit est un produit de Cannon (cannonProduct())
+ * @param D : le bloc de W du processeur, remplacé par le bloc du résultat
+ * @param block_size : le côté des blocs
+ * @param grid : la grille de processeurs
+ * @param squaring : 1 pour les élévations au carré, 0 pour les produits par W
+ * @param nbr_products : le nombre maximal de produits
+ * @return le nombre de produits effectués
+ */
+int gridToN(struct Matrix* D, int block_size, struct Grid* grid, int squaring, int nbr_products) {
+    struct Matrix* A = allocateMatrix(block_size, block_size);
+    struct Matrix* BT = allocateMatrix(block_size, block_size);
+    struct Matrix* result = allocateMatrix(block_size, block_size);
+    struct Matrix* partial = allocateMatrix(block_size, block_size);
+    struct Matrix* buffer = allocateMatrix(block_size, block_size);
+    int count = blockCount(D, block_size);
+    int n = 0;
+    
+    // Produits par W : B est décalé une fois pour toutes et revient à sa place après chaque produit
+    if (!squaring) {
+        transposeBlock(D, BT, block_size);
+        shiftBlock(BT, buffer, block_size, grid->j, grid->column);
+    }
+    
+    while (n < nbr_products) {
+        memcpy(A->data, D->data, sizeof(unsigned int) * count);
+        shiftBlock(A, buffer, block_size, grid->i, grid->row);
+        if (squaring) {
+            transposeBlock(D, BT, block_size);
+            shiftBlock(BT, buffer, block_size, grid->j, grid->column);
+        }
+        
+        cannonProduct(A, BT, result, partial, buffer, block_size, grid);
+        n++;
+        
+        int changed = squaring ? hasChanged(D, result, block_size, block_size) : 1;
+        unsigned int* data = D->data;
+        D->data = result->data;
+        result->data = data;
+        if (!changed)
+            break;
+    }
+    
+    freeMatrix(A);
+    freeMatrix(BT);
+    freeMatrix(result);
+    freeMatrix(partial);
+    freeMatrix(buffer);
+    
+    return n;
+}
+
+/**
+ * Options de la ligne de commande
+ */
+struct options {
+    char *path; // Fichier d'entrée
+    int timing; // --time : affichage par P0 du temps de chaque étape et du nombre de messages sur la sortie d'erreur
+    int products; // --products <k> : nombre de produits min-plus limité à k (mesures sur de grands graphes, 0 : tab_size - 1)
+    int blocked; // --blocked : Floyd-Warshall par blocs sur P0 (blockedFloyd()) au lieu des produits sur l'anneau
+    int tile; // --tile <n> : côté des carreaux de --blocked
+    int squaring; // --squaring : élévations au carré successives avec arrêt à convergence (squareToN()) au lieu de elevateToN()
+    char *kernel; // --kernel <scalar|avx2|avx512> : noyau de floyd() (NULL : le plus large supporté, voir chooseKernel())
+    int grid; // --grid : grille q x q de processeurs et produits de Cannon (gridToN()) au lieu de l'anneau
+    int sparse; // --sparse : 1, Dijkstra depuis chaque sommet (sparseAPSP()) ; --dense : 0, produits min-plus ; -1 : selon SPARSE_DENSITY
+    int paths; // --paths : matrice des successeurs calculée avec les distances sur l'anneau (voir floydPaths())
+    char *query; // --query <fichier> : chemins des couples "source destination" du fichier, affichés après la matrice (avec --paths)
+};
+
+/**
+ * Lecture des options de la ligne de commande
+ * @param argc : le nombre d'arguments
+ * @param argv : les arguments
+ * @return les options lues
+ */
+struct options parseOptions(int argc, char* argv[]) {
+    struct options options = { NULL, 0, 0, 0, FLOYD_TILE, 0, NULL, 0, -1, 0, NULL };
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--time") == 0)
+            options.timing = 1;
+        else if (strcmp(argv[i], "--products") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.products = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--squaring") == 0)
+            options.squaring = 1;
+        else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc)
+            options.kernel = argv[++i];
+        else if (strcmp(argv[i], "--paths") == 0)
+            options.paths = 1;
+        else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+            options.paths = 1;
+            options.query = argv[++i];
+        }
+        else if (strcmp(argv[i], "--sparse") == 0)
+            options.sparse = 1;
+        else if (strcmp(argv[i], "--dense") == 0)
+            options.sparse = 0;
+        else if (strcmp(argv[i], "--grid") == 0)
+            options.grid = 1;
+        else if (strcmp(argv[i], "--blocked") == 0)
+            options.blocked = 1;
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            options.tile = atoi(argv[++i]);
+        else
+            options.path = argv[i];
+    }
+    
+    if (options.path == NULL) {
         printf("Fichier manquant en paramètre\n");
         exit(1);
     }
     
+    // Le moteur creux ne remplace que les produits sur l'anneau : --grid et --blocked ont leur propre moteur dense
+    if (options.sparse == 1 && (options.blocked || options.grid)) {
+        printf("Erreur : --sparse n'est pas compatible avec --blocked et --grid\n");
+        exit(1);
+    }
+    
+    // Les successeurs ne sont calculés que par les produits sur l'anneau
+    if (options.paths && (options.blocked || options.grid || options.sparse == 1)) {
+        printf("Erreur : --paths n'est disponible qu'avec les produits sur l'anneau\n");
+        exit(1);
+    }
+    if (options.paths)
+        options.sparse = 0;
+    
+    return options;
+}
+
+/**
+ * Affiche sur la sortie d'erreur la durée d'une étape si l'option --time est active (P0 seulement)
+ * @param options : les options de la ligne de commande
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @param step : le nom de l'étape
+ * @param start : l'instant de début de l'étape (MPI_Wtime())
+ * @return l'instant de fin de l'étape
+ */
+double printTime(struct options* options, int rank, char* step, double start) {
+    double now = MPI_Wtime();
+    
+    if (options->timing && rank == 0)
+        fprintf(stderr, "%s : %f s\n", step, now - start);
+    
+    return now;
+}
+
+/**
+ * Affiche sur la sortie d'erreur le noyau de floyd() et son débit si l'option --time est active (P0 seulement) : une addition
+ * et un minimum pour chacun des N termes des N^2 cases, à chaque produit
+ * @param options : les options de la ligne de commande
+ * @param rank : le rang du processeur qui appelle la méthode
+ * @param tab_size : le nombre de sommets N
+ * @param nbr_products : le nombre de produits effectués
+ * @param seconds : la durée des produits
+ * @return void
+ */
+void printKernel(struct options* options, int rank, int tab_size, int nbr_products, double seconds) {
+    char* names[] = { "scalar", "avx2", "avx512" };
+    
+    if (options->timing && rank == 0) {
+        fprintf(stderr, "kernel : %s\n", names[kernel]);
+        fprintf(stderr, "gops : %f\n", 2.0 * tab_size * tab_size * tab_size * nbr_products / seconds / 1e9);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    struct options options = parseOptions(argc, argv);
+    kernel = chooseKernel(options.kernel);
+    
     int rank;
     int nbr_procs;
-    int nbr_procs_used;
     
-    MPI_Init(&argc, &argv);
+    // Appels MPI par le thread principal seulement, hors des régions parallèles OpenMP
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &nbr_procs);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     
+    // Tous les processeurs vérifient la grille et s'arrêtent proprement ensemble
+    if (options.grid) {
+        int q = 1;
+        while ((q + 1) * (q + 1) <= nbr_procs)
+            q++;
+        if (q * q != nbr_procs) {
+            if (rank == 0)
+                printf("Erreur : --grid demande un nombre carré de processeurs (%d)\n", nbr_procs);
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    
     int previous = ((rank - 1 + nbr_procs) % nbr_procs);
     int next = ((rank + 1) % nbr_procs);
     
     int tab_size;
     int nbr_tab;
+    int nbr_products;
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    double time = MPI_Wtime();
+    
+    // Version sur un seul nœud : P0 calcule tout, les autres processeurs n'ont rien à faire
+    if (options.blocked) {
+        if (rank == 0) {
+            struct Matrix* A = parseFileAndFillMatrix(options.path);
+            time = printTime(&options, rank, "parse", time);
+            
+            struct Matrix* W = transformToW(A);
+            time = printTime(&options, rank, "transformToW", time);
+            
+            blockedFloyd(W, options.tile);
+            time = printTime(&options, rank, "blockedFloyd", time);
+            
+            printMatrix(W);
+            time = printTime(&options, rank, "printMatrix", time);
+            
+            freeMatrix(A);
+            freeMatrix(W);
+        }
+        
+        MPI_Finalize();
+        
+        return 0;
+    }
     
     struct Matrix* W_row;
     struct Matrix* W_column;
     
     struct Matrix* result;
+    
+    // Choix du moteur : P0 lit le graphe au format CSR et mesure la densité des arcs (la grille lit directement la matrice)
+    struct Graph* graph = NULL;
+    int sparse = options.grid ? 0 : options.sparse;
+    if (!options.grid && rank == 0) {
+        graph = parseFileToGraph(options.path);
+        time = printTime(&options, rank, "parse", time);
         
-    if (rank == 0) {
-        // Parse du fichier
-        struct Matrix* A = parseFileAndFillMatrix(argv[1]);
-        
-        // Transformation de la matrice A en matrice adjacente W
-        struct Matrix* W = transformToW(A);
+        double density = graph->vertices > 1 ? (double) graph->edges / ((double) graph->vertices * (graph->vertices - 1)) : 1;
+        if (sparse < 0)
+            sparse = density < SPARSE_DENSITY;
+        if (options.timing)
+            fprintf(stderr, "density : %f (%s)\n", density, sparse ? "sparse" : "dense");
+    }
+    MPI_Bcast(&sparse, 1, MPI_INT, 0, MPI_COMM_WORLD);
         
-        // Définition des variables
-        tab_size = W->rows;
+    if (options.grid) {
+        // Grille q x q : chaque processeur tient un bloc de (N / q) x (N / q) cases de la matrice
+        struct Grid grid = createGrid(nbr_procs);
+        struct Matrix* A = NULL;
+        struct Matrix* W = NULL;
         
-        if ((tab_size / nbr_procs) < 1) {
-            nbr_tab = 1;
-            nbr_procs_used = tab_size;
-        } else {
-            nbr_tab = (int) (tab_size / nbr_procs);
-            nbr_procs_used = nbr_procs;
+        if (rank == 0) {
+            A = parseFileAndFillMatrix(options.path);
+            time = printTime(&options, rank, "parse", time);
+            
+            W = transformToW(A);
+            time = printTime(&options, rank, "transformToW", time);
+            tab_size = W->rows;
         }
         
-        // Allocation mémoire des matrices
-        W_row = allocateMatrix(tab_size, nbr_tab);
-        W_column = allocateMatrix(tab_size, nbr_tab);
-        result = allocateMatrix(tab_size, tab_size);
+        MPI_Bcast(&tab_size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        int block_size = (tab_size + grid.q - 1) / grid.q;
+        struct Matrix* D = allocateMatrix(block_size, block_size);
         
-        // Broadcast sur anneau du nombre de ligne(s) / colonne(s) à traiter par chaque processeur et de la taille d'une ligne / colonne
-        broadcast(&tab_size, rank, previous, next);
-        broadcast(&nbr_tab, rank, previous, next);
+        scatterBlocks(W, D, tab_size, block_size, &grid);
+        time = printTime(&options, rank, "scatter", time);
         
-        // Création des matrices lignes et colonnes sur lesquelles on va travailler pour éviter d'utiliser la matrice W
-        #pragma omp parallel for
-        for (int i = 0; i < nbr_tab; i++) {
-            W_row->data[i] = W->data[i];
-            W_column->data[i] = transpose(W)->data[i];
-        }
+        nbr_products = options.squaring ? squaringCount(tab_size) : tab_size - 1;
+        if (options.products > 0 && options.products < nbr_products)
+            nbr_products = options.products;
+        
+        double start = time;
+        nbr_products = gridToN(D, block_size, &grid, options.squaring, nbr_products);
+        time = printTime(&options, rank, "gridToN", time);
+        if (options.timing && options.squaring && rank == 0)
+            fprintf(stderr, "products : %d\n", nbr_products);
+        printKernel(&options, rank, tab_size, nbr_products, time - start);
+        
+        result = rank == 0 ? allocateMatrix(tab_size, tab_size) : NULL;
+        gatherBlocks(D, result, tab_size, block_size, &grid);
+        time = printTime(&options, rank, "gather", time);
+        
+        if (rank == 0) {
+            printMatrix(result);
+            time = printTime(&options, rank, "printMatrix", time);
             
-        // Scatter W en lignes et en colonnes
-        scatter(W, previous, next, nbr_tab, tab_size, nbr_procs_used, rank, TAG_SCATTER_ROWS);
-        scatter(transpose(W), previous, next, nbr_tab, tab_size, nbr_procs_used, rank, TAG_SCATTER_COLUMNS);
-
-        // On élève la matrice ligne (W_row) à la puissance N
-        elevateToN(W_row, W_column, result, nbr_tab, tab_size, next, previous, nbr_procs_used, rank);
+            freeMatrix(A);
+            freeMatrix(W);
+            freeMatrix(result);
+        }
+        freeMatrix(D);
+        freeGrid(&grid);
+    } else if (sparse) {
+        // Chaque processeur reçoit tout le graphe et calcule les lignes de ses sommets de départ
+        graph = broadcastGraph(graph, rank, nbr_procs);
+        tab_size = graph->vertices;
+        int* counts = malloc(sizeof(int) * nbr_procs);
+        int* displs = malloc(sizeof(int) * nbr_procs);
+        distribute(tab_size, nbr_procs, counts, displs);
+        nbr_tab = counts[rank];
+        result = allocateMatrix(tab_size, rank == 0 ? tab_size : nbr_tab);
+        time = printTime(&options, rank, "broadcastGraph", time);
         
-        // Récupération de tous les résultats
-        gatherFinal(result, previous, nbr_tab, tab_size, nbr_procs_used);
-
-        // Affichage du résultat final
-        printMatrix(result);
+        sparseAPSP(graph, result, displs[rank], nbr_tab);
+        time = printTime(&options, rank, "dijkstra", time);
         
-        freeMatrix(A);
-        freeMatrix(W_row);
-        freeMatrix(W_column);
+        gather(result, counts, displs, nbr_procs, rank);
+        time = printTime(&options, rank, "gather", time);
+        
+        if (rank == 0) {
+            printMatrix(result);
+            time = printTime(&options, rank, "printMatrix", time);
+        }
         freeMatrix(result);
+        freeGraph(graph);
+        free(counts);
+        free(displs);
     } else {
-        // Broadcast sur anneau du nombre de ligne(s) / colonne(s) à traiter par chaque processeur et de la taille d'une ligne / colonne
-        broadcast(&tab_size, rank, previous, next);
-        broadcast(&nbr_tab, rank, previous, next);
+        struct Matrix* A = NULL;
+        struct Matrix* W = NULL;
+        struct Matrix* WT = NULL;
         
-        // Définition des variables
-        if ((tab_size / nbr_procs) < 1) {
-            nbr_procs_used = tab_size;
-        }
-        else {
-            nbr_procs_used = nbr_procs;
+        if (rank == 0) {
+            // Matrice du graphe lu
+            A = graphToMatrix(graph);
+            freeGraph(graph);
+            
+            // Transformation de la matrice A en matrice adjacente W
+            W = transformToW(A);
+            WT = transpose(W);
+            time = printTime(&options, rank, "transformToW", time);
+            
+            tab_size = W->rows;
         }
-
-        // Allocation des matrices
+        
+        // Taille de la matrice, puis répartition équilibrée des lignes et des colonnes (calculée par chaque processeur)
+        MPI_Bcast(&tab_size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        int* counts = malloc(sizeof(int) * nbr_procs);
+        int* displs = malloc(sizeof(int) * nbr_procs);
+        distribute(tab_size, nbr_procs, counts, displs);
+        nbr_tab = counts[rank];
+        
+        // Allocation mémoire des matrices : les colonnes des autres processeurs passent par "W_column", qui doit contenir le
+        // plus grand bloc (celui de P0) ; P0 reçoit toute la matrice résultat
         W_row = allocateMatrix(tab_size, nbr_tab);
-        W_column = allocateMatrix(tab_size, nbr_tab);
-        result = allocateMatrix(tab_size, nbr_tab);
+        W_column = allocateMatrix(tab_size, counts[0]);
+        result = allocateMatrix(tab_size, rank == 0 ? tab_size : nbr_tab);
         
-        // Scatter W_row et W_column
-        scatter(W_row, previous, next, nbr_tab, tab_size, nbr_procs_used, rank, TAG_SCATTER_ROWS);
-        scatter(W_column, previous, next, nbr_tab, tab_size, nbr_procs_used, rank, TAG_SCATTER_COLUMNS);
+        // Scatter W en lignes et en colonnes
+        scatter(W, W_row, counts, displs, nbr_procs, rank);
+        scatter(WT, W_column, counts, displs, nbr_procs, rank);
+        time = printTime(&options, rank, "scatter", time);
         
-        // On élève la matrice ligne (à savoir "W_row") à la puissance N
-        elevateToN(W_row, W_column, result, nbr_tab, tab_size, next, previous, nbr_procs_used, rank);
-
-        // Récupération des résultats des suivants et envoie des résultats au précédent
-        gather(result, previous, next, nbr_tab, tab_size, rank);
+        // Successeurs des lignes de W (--paths), et place occupée sur chaque processeur par rapport aux distances
+        struct Hops* hops = NULL;
+        if (options.paths) {
+            hops = allocateHops(tab_size, nbr_tab);
+            initHops(W_row, hops, nbr_tab);
+            if (options.timing && rank == 0) {
+                fprintf(stderr, "memory distances : %zu octets\n", sizeof(unsigned int) * (size_t) blockCount(W_row, 2 * nbr_tab + 2 * counts[0]));
+                fprintf(stderr, "memory hops : %zu octets (%d par case)\n", 2 * (size_t) hops->width * tab_size * nbr_tab, hops->width);
+            }
+        }
+        
+        nbr_products = options.squaring ? squaringCount(tab_size) : tab_size - 1;
+        if (options.products > 0 && options.products < nbr_products)
+            nbr_products = options.products;
         
+        // On élève la matrice ligne (W_row) à la puissance N
+        double start = time;
+        if (options.squaring) {
+            nbr_products = squareToN(W_row, W_column, result, nbr_tab, tab_size, next, previous, counts, displs, nbr_procs, rank, nbr_products, hops);
+            time = printTime(&options, rank, "squareToN", time);
+            if (options.timing && rank == 0)
+                fprintf(stderr, "products : %d\n", nbr_products);
+        } else {
+            elevateToN(W_row, W_column, result, nbr_tab, tab_size, next, previous, counts, displs, nbr_procs, rank, nbr_products, hops);
+            time = printTime(&options, rank, "elevateToN", time);
+        }
+        printKernel(&options, rank, tab_size, nbr_products, time - start);
+        
+        // Récupération de tous les résultats
+        gather(result, counts, displs, nbr_procs, rank);
+        struct Hops* allHops = NULL;
+        if (options.paths) {
+            allHops = rank == 0 ? allocateHops(tab_size, tab_size) : NULL;
+            gatherHops(hops, allHops, counts, displs, nbr_procs, rank);
+        }
+        time = printTime(&options, rank, "gather", time);
+        
+        if (rank == 0) {
+            // Affichage du résultat final
+            printMatrix(result);
+            time = printTime(&options, rank, "printMatrix", time);
+            
+            // Chemins demandés, retrouvés par les successeurs
+            if (options.query != NULL) {
+                queryPaths(options.query, result, allHops);
+                time = printTime(&options, rank, "queryPaths", time);
+            }
+            
+            freeMatrix(A);
+            freeMatrix(W);
+            freeMatrix(WT);
+        }
         freeMatrix(W_row);
         freeMatrix(W_column);
         freeMatrix(result);
+        freeHops(hops);
+        freeHops(allHops);
+        free(counts);
+        free(displs);
+    }
+    
+    // Nombre total de messages envoyés par les processeurs
+    long total_messages;
+    MPI_Reduce(&nbr_messages, &total_messages, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (options.timing && rank == 0)
+        fprintf(stderr, "messages : %ld\n", total_messages);
+    
+    // Communication de l'anneau recouverte par le calcul / exposée, pour chaque processeur
+    double comm[2] = { comm_hidden, comm_exposed };
+    double* comms = rank == 0 ? malloc(sizeof(double) * 2 * nbr_procs) : NULL;
+    MPI_Gather(comm, 2, MPI_DOUBLE, comms, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (options.timing && rank == 0 && !options.grid) {
+        for (int r = 0; r < nbr_procs; r++)
+            fprintf(stderr, "hidden P%d : %f s\nexposed P%d : %f s\n", r, comms[2 * r], r, comms[2 * r + 1]);
     }
+    free(comms);
     
     MPI_Finalize();
     